@@ -0,0 +1,195 @@
+// Copyright (c) 2014, Salesforce.com, Inc.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+// - Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// - Neither the name of Salesforce.com nor the names of its contributors
+//   may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+// COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+// OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+// TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <distributions/random.hpp>
+#include <distributions/sparse.hpp>
+#include <distributions/vector.hpp>
+#include <distributions/models/dpd.hpp>
+#include <distributions/models/nich.hpp>
+#include "harness.hpp"
+
+// This compares allocation-heavy workloads under the default allocators
+// and the pool allocator: short-lived score vectors, sparse counters
+// whose keys come and go, and mixtures whose groups are added and removed.
+// Mixture benchmarks use the allocators selected by DIST_POOL_ALLOCATOR,
+// and compare growing on demand to reserving capacity up front.
+
+using namespace distributions;  // NOLINT(*)
+using distributions::benchmark::Harness;
+using distributions::benchmark::Options;
+using distributions::benchmark::escape;
+
+rng_t rng;
+
+//----------------------------------------------------------------------------
+// vectors
+
+template<class Alloc>
+void add_vectors(Harness & harness, const std::string & alloc_name) {
+    typedef Packed_<float, Alloc> Vector;
+    for (size_t size = 16; size <= 1024; size *= 64) {
+        std::ostringstream name;
+        name << "vector_create/" << alloc_name << '/' << size;
+        harness.add(name.str(), 1, [size](){
+            Vector vector(size);
+            escape(vector.data());
+        });
+    }
+
+    const size_t grow_size = 1024;
+    harness.add("vector_grow/" + alloc_name, grow_size, [](){
+        Vector vector;
+        for (size_t i = 0; i < grow_size; ++i) {
+            vector.packed_add(i);
+        }
+        escape(vector.data());
+    });
+}
+
+//----------------------------------------------------------------------------
+// sparse counters
+
+const size_t key_count = 1000;
+const size_t group_size = 32;
+
+template<class Alloc>
+void add_sparse_counters(Harness & harness, const std::string & alloc_name) {
+    typedef SparseCounter<uint32_t, int, Alloc> Counter;
+
+    auto keys = std::make_shared<std::vector<uint32_t>>();
+    for (size_t i = 0; i < group_size; ++i) {
+        keys->push_back(sample_int(rng, 0, key_count - 1));
+    }
+
+    // a group that is created, filled and destroyed, as in remove_group
+    harness.add("sparse_group/" + alloc_name, group_size, [keys](){
+        Counter counter;
+        for (auto key : *keys) {
+            counter.add(key);
+        }
+        escape(&counter);
+    });
+
+    // a group whose values are removed and re-added, so that each key's
+    // count returns to zero and its node is freed
+    auto counter = std::make_shared<Counter>();
+    harness.add("sparse_toggle/" + alloc_name, group_size, [keys, counter](){
+        for (auto key : *keys) {
+            counter->add(key);
+            escape(counter.get());
+            counter->remove(key);
+            escape(counter.get());
+        }
+    });
+}
+
+//----------------------------------------------------------------------------
+// mixtures
+
+template<class Model>
+struct ChurnFixture {
+    typedef typename Model::Value Value;
+    typedef typename Model::Shared Shared;
+    typedef typename Model::Group Group;
+    typedef typename Model::Mixture Mixture;
+
+    Shared shared;
+    Mixture mixture;
+    std::vector<Value> values;
+
+    ChurnFixture(size_t group_count, bool reserve) {
+        shared = Shared::EXAMPLE();
+        Group empty;
+        empty.init(shared, rng);
+        typename Model::Sampler sampler;
+        sampler.init(shared, empty, rng);
+        for (size_t i = 0; i < group_size; ++i) {
+            values.push_back(sampler.eval(shared, rng));
+        }
+
+        mixture.groups().resize(group_count);
+        for (auto & group : mixture.groups()) {
+            group.init(shared, rng);
+        }
+        mixture.init(shared, rng);
+        if (reserve) {
+            mixture.reserve(2 * group_count);
+        }
+    }
+
+    // adds a group, fills and empties it, then removes it
+    void churn() {
+        const size_t groupid = mixture.groups().size();
+        mixture.add_group(shared, rng);
+        for (const auto & value : values) {
+            mixture.add_value(shared, groupid, value, rng);
+        }
+        for (const auto & value : values) {
+            mixture.remove_value(shared, groupid, value, rng);
+        }
+        mixture.remove_group(shared, groupid);
+    }
+};
+
+template<class Model>
+void add_mixture(Harness & harness, const std::string & model_name) {
+    const std::string alloc_name = DIST_POOL_ALLOCATOR ? "pool" : "default";
+    for (size_t group_count = 10; group_count <= 1000; group_count *= 10) {
+        for (bool reserve : {false, true}) {
+            auto f = std::make_shared<ChurnFixture<Model>>(
+                group_count,
+                reserve);
+            std::ostringstream name;
+            name << model_name << "_churn/" << alloc_name << '/'
+                 << (reserve ? "reserved" : "unreserved") << '/'
+                 << group_count;
+            harness.add(name.str(), 1, [f](){ f->churn(); });
+        }
+    }
+}
+
+int main(int argc, char ** argv) {
+    const Options options(argc, argv);
+    Harness harness(options);
+
+    add_vectors<aligned_allocator<float>>(harness, "aligned");
+    add_vectors<pool_allocator<float>>(harness, "pool");
+    add_sparse_counters<std::allocator<std::pair<const uint32_t, int>>>(
+        harness,
+        "std");
+    add_sparse_counters<pool_allocator<std::pair<const uint32_t, int>>>(
+        harness,
+        "pool");
+    add_mixture<DirichletProcessDiscrete>(harness, "dpd");
+    add_mixture<NormalInverseChiSq>(harness, "nich");
+
+    return harness.run();
+}
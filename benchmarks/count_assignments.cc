@@ -0,0 +1,99 @@
+// Copyright (c) 2014, Salesforce.com, Inc.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+// - Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// - Neither the name of Salesforce.com nor the names of its contributors
+//   may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+// COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+// OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+// TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <iostream>
+#include <iomanip>
+#include <cstdio>
+#include <distributions/random.hpp>
+#include <distributions/clustering.hpp>
+#include <distributions/timers.hpp>
+
+using namespace distributions;  // NOLINT(*)
+
+typedef Clustering<int> Clustering_;
+
+size_t speedtest(size_t size, size_t iters, float alpha, float d) {
+    Clustering_::PitmanYor model;
+    model.alpha = alpha;
+    model.d = d;
+
+    rng_t rng;
+    const Clustering_::AssignmentVector assignments =
+        model.sample_assignments_fast(size, rng);
+
+    // maps are too large to build beyond this size
+    const size_t max_map_size = 10000000;
+    size_t bogus = 0;
+    int64_t map_time = 0;
+    if (size <= max_map_size) {
+        Clustering_::Assignments map;
+        for (size_t i = 0; i < size; ++i) {
+            map[i] = assignments[i];
+        }
+        map_time -= current_time_us();
+        for (size_t i = 0; i < iters; ++i) {
+            bogus += Clustering_::count_assignments(map).size();
+        }
+        map_time += current_time_us();
+    }
+
+    int64_t vector_time = -current_time_us();
+    for (size_t i = 0; i < iters; ++i) {
+        bogus += Clustering_::count_assignments(assignments).size();
+    }
+    vector_time += current_time_us();
+
+    double map_rows_per_sec =
+        map_time ? size * iters / (map_time * 1e-6) : 0;
+    double vector_rows_per_sec = size * iters / (vector_time * 1e-6);
+    std::cout <<
+        size << '\t' <<
+        std::right << std::setw(12) << std::scientific <<
+        std::setprecision(2) << map_rows_per_sec << '\t' <<
+        std::right << std::setw(12) << std::scientific <<
+        std::setprecision(2) << vector_rows_per_sec << '\n';
+
+    return bogus;
+}
+
+int main(int argc, char ** argv) {
+    float alpha = (argc > 1) ? atof(argv[1]) : 1.0f;
+    float d = (argc > 2) ? atof(argv[2]) : 0.2f;
+
+    std::cout << "size" << '\t' << "map rows/sec" << '\t' << "vec rows/sec";
+    std::cout << " (alpha = " << alpha << ", d = " << d << ")\n";
+
+    size_t min_exponent = 3;
+    size_t max_exponent = 8;
+    for (size_t i = min_exponent; i <= max_exponent; ++i) {
+        size_t size = size_t(round(pow(10, i)));
+        size_t iters = std::max<size_t>(1, 100000000 / size);
+        speedtest(size, iters, alpha, d);
+    }
+
+    return 0;
+}
@@ -0,0 +1,352 @@
+// Copyright (c) 2014, Salesforce.com, Inc.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+// - Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// - Neither the name of Salesforce.com nor the names of its contributors
+//   may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+// COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+// OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+// TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <distributions/random.hpp>
+#include <distributions/timers.hpp>
+#include <distributions/clustering.hpp>
+#include <distributions/mixture.hpp>
+#include <distributions/models/bb.hpp>
+#include <distributions/models/dd.hpp>
+#include <distributions/models/dpd.hpp>
+#include <distributions/models/gp.hpp>
+#include <distributions/models/nich.hpp>
+#include <distributions/models/niw.hpp>
+
+// This runs complete Gibbs sweeps over a synthetic dataset of mixed
+// feature types, as a mixture model over rows would: each row is removed,
+// scored against every group by the clustering prior plus every feature,
+// then resampled and added back.
+
+using namespace distributions;  // NOLINT(*)
+
+typedef Clustering<int>::PitmanYor Clustering_;
+
+rng_t rng;
+
+// --------------------------------------------------------------------------
+// Features
+
+struct Feature {
+    virtual ~Feature() {}
+    virtual const char * name() const = 0;
+    virtual void init(const std::vector<size_t> & groupids, size_t size) = 0;
+    virtual void add_group() = 0;
+    virtual void remove_group(size_t groupid) = 0;
+    virtual void add_value(size_t groupid, size_t row) = 0;
+    virtual void remove_value(size_t groupid, size_t row) = 0;
+    virtual void score_value(size_t row, VectorFloat & scores) const = 0;
+};
+
+template<class Model>
+struct Feature_ : Feature {
+    typedef typename Model::Value Value;
+
+    const char * const name_;
+    typename Model::Shared shared;
+    typename Model::Mixture mixture;
+    std::vector<Value> values;
+
+    Feature_(
+            const char * name,
+            const std::vector<size_t> & true_assignments,
+            size_t true_group_count) :
+        name_(name),
+        shared(Model::Shared::EXAMPLE()) {
+        // each true group samples its own parameters from the prior
+        typename Model::Group empty;
+        empty.init(shared, rng);
+        std::vector<typename Model::Sampler> samplers(true_group_count);
+        for (auto & sampler : samplers) {
+            sampler.init(shared, empty, rng);
+        }
+        values.reserve(true_assignments.size());
+        for (size_t groupid : true_assignments) {
+            values.push_back(samplers[groupid].eval(shared, rng));
+        }
+    }
+
+    const char * name() const { return name_; }
+
+    void init(const std::vector<size_t> & groupids, size_t size) {
+        mixture.groups().resize(size);
+        for (auto & group : mixture.groups()) {
+            group.init(shared, rng);
+        }
+        for (size_t row = 0; row < values.size(); ++row) {
+            mixture.groups(groupids[row]).add_value(shared, values[row], rng);
+        }
+        mixture.init(shared, rng);
+    }
+
+    void add_group() {
+        mixture.add_group(shared, rng);
+    }
+
+    void remove_group(size_t groupid) {
+        mixture.remove_group(shared, groupid);
+    }
+
+    void add_value(size_t groupid, size_t row) {
+        mixture.add_value(shared, groupid, values[row], rng);
+    }
+
+    void remove_value(size_t groupid, size_t row) {
+        mixture.remove_value(shared, groupid, values[row], rng);
+    }
+
+    void score_value(size_t row, VectorFloat & scores) const {
+        mixture.score_value(shared, values[row], scores, rng);
+    }
+};
+
+template<class Model>
+Feature * new_feature(
+        const char * name,
+        const std::vector<size_t> & true_assignments,
+        size_t true_group_count) {
+    return new Feature_<Model>(name, true_assignments, true_group_count);
+}
+
+// --------------------------------------------------------------------------
+// Sampler
+
+struct Phases {
+    enum { REMOVE, SCORE, SAMPLE, ADD, COUNT };
+    int64_t ns[COUNT] = {0, 0, 0, 0};
+
+    static const char * name(size_t phase) {
+        static const char * names[COUNT] =
+            {"remove", "score", "sample", "add"};
+        return names[phase];
+    }
+};
+
+class GibbsSampler {
+  public:
+    GibbsSampler(
+            std::vector<std::unique_ptr<Feature>> && features,
+            size_t row_count,
+            size_t group_count) :
+        features_(std::move(features)),
+        assignments_(row_count) {
+        clustering_.alpha = 1.f;
+        clustering_.d = 0.1f;
+
+        // start from a uniform partition plus one empty group
+        std::vector<size_t> groupids(row_count);
+        std::vector<int> counts(group_count + 1, 0);
+        for (size_t row = 0; row < row_count; ++row) {
+            groupids[row] = row % group_count;
+            ++counts[groupids[row]];
+        }
+        clustering_mixture_.counts() = counts;
+        clustering_mixture_.init(clustering_);
+        for (auto & feature : features_) {
+            feature->init(groupids, group_count + 1);
+        }
+        ids_.init(group_count + 1);
+        for (size_t row = 0; row < row_count; ++row) {
+            assignments_[row] = ids_.packed_to_global(groupids[row]);
+        }
+    }
+
+    size_t group_count() const { return clustering_mixture_.counts().size(); }
+
+    // returns the number of cells scored, i.e. sum of rows x groups
+    size_t sweep(Phases & phases) {
+        size_t cell_count = 0;
+        const size_t row_count = assignments_.size();
+        for (size_t row = 0; row < row_count; ++row) {
+            int64_t time = current_time_ns();
+            auto lap = [&](size_t phase) {
+                const int64_t now = current_time_ns();
+                phases.ns[phase] += now - time;
+                time = now;
+            };
+
+            size_t groupid = ids_.global_to_packed(assignments_[row]);
+            for (auto & feature : features_) {
+                feature->remove_value(groupid, row);
+            }
+            if (clustering_mixture_.remove_value(clustering_, groupid)) {
+                ids_.remove_group(groupid);
+                for (auto & feature : features_) {
+                    feature->remove_group(groupid);
+                }
+            }
+            lap(Phases::REMOVE);
+
+            const size_t group_count = clustering_mixture_.counts().size();
+            scores_.resize(group_count);
+            clustering_mixture_.score_value_unnormalized(
+                clustering_,
+                scores_);
+            for (const auto & feature : features_) {
+                feature->score_value(row, scores_);
+            }
+            cell_count += group_count * features_.size();
+            lap(Phases::SCORE);
+
+            groupid = sample_from_scores_overwrite(rng, scores_);
+            lap(Phases::SAMPLE);
+
+            if (clustering_mixture_.add_value(clustering_, groupid)) {
+                ids_.add_group();
+                for (auto & feature : features_) {
+                    feature->add_group();
+                }
+            }
+            for (auto & feature : features_) {
+                feature->add_value(groupid, row);
+            }
+            assignments_[row] = ids_.packed_to_global(groupid);
+            lap(Phases::ADD);
+        }
+        return cell_count;
+    }
+
+  private:
+    std::vector<std::unique_ptr<Feature>> features_;
+    Clustering_ clustering_;
+    Clustering_::Mixture clustering_mixture_;
+    MixtureIdTracker ids_;
+    std::vector<MixtureIdTracker::Id> assignments_;
+    VectorFloat scores_;
+};
+
+// --------------------------------------------------------------------------
+// Main
+
+inline double max_rss_mb() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0;  // ru_maxrss is in KB on linux
+}
+
+int main(int argc, char ** argv) {
+    const size_t row_count = (argc > 1) ? atoi(argv[1]) : 10000;
+    const size_t col_count = (argc > 2) ? atoi(argv[2]) : 12;
+    const size_t group_count = (argc > 3) ? atoi(argv[3]) : 10;
+    const size_t sweep_count = (argc > 4) ? atoi(argv[4]) : 5;
+    DIST_ASSERT(row_count > 0, "expected rows > 0");
+    DIST_ASSERT(group_count > 0, "expected groups > 0");
+
+    std::cout <<
+        row_count << " rows, " <<
+        col_count << " cols, " <<
+        group_count << " initial groups, " <<
+        sweep_count << " sweeps\n";
+
+    // the true partition has about group_count groups
+    int64_t time = -current_time_us();
+    Clustering_ truth;
+    truth.alpha = group_count / std::log(1.0 + row_count);
+    truth.d = 0;
+    std::vector<size_t> true_assignments;
+    for (int groupid : truth.sample_assignments_fast(row_count, rng)) {
+        true_assignments.push_back(groupid);
+    }
+    const size_t true_group_count =
+        Clustering<int>::count_assignments(
+            std::vector<int>(
+                true_assignments.begin(),
+                true_assignments.end())).size();
+
+    typedef Feature * (*Factory)(
+        const char *,
+        const std::vector<size_t> &,
+        size_t);
+    const std::vector<std::pair<const char *, Factory>> factories = {
+        {"bb", new_feature<BetaBernoulli>},
+        {"dd16", new_feature<DirichletDiscrete<16>>},
+        {"dpd", new_feature<DirichletProcessDiscrete>},
+        {"gp", new_feature<GammaPoisson>},
+        {"nich", new_feature<NormalInverseChiSq>},
+        {"niw3", new_feature<NormalInverseWishart<3>>},
+    };
+    std::vector<std::unique_ptr<Feature>> features;
+    std::cout << "features:";
+    for (size_t col = 0; col < col_count; ++col) {
+        const auto & factory = factories[col % factories.size()];
+        features.emplace_back(
+            factory.second(factory.first, true_assignments, true_group_count));
+        std::cout << ' ' << factory.first;
+    }
+    std::cout << '\n';
+
+    GibbsSampler sampler(std::move(features), row_count, group_count);
+    time += current_time_us();
+    std::cout << "generated " << true_group_count << " true groups in " <<
+        std::fixed << std::setprecision(2) << (time * 1e-6) << " sec\n\n";
+
+    std::cout <<
+        std::setw(6) << "sweep" <<
+        std::setw(8) << "groups" <<
+        std::setw(12) << "rows/sec" <<
+        std::setw(12) << "cells/sec" <<
+        std::setw(12) << "max rss MB" << '\n';
+    Phases phases;
+    for (size_t sweep = 0; sweep < sweep_count; ++sweep) {
+        int64_t time = -current_time_ns();
+        const size_t cell_count = sampler.sweep(phases);
+        time += current_time_ns();
+        const double sec = time * 1e-9;
+        std::cout <<
+            std::setw(6) << sweep <<
+            std::setw(8) << sampler.group_count() <<
+            std::scientific << std::setprecision(2) <<
+            std::setw(12) << row_count / sec <<
+            std::setw(12) << cell_count / sec <<
+            std::fixed << std::setprecision(1) <<
+            std::setw(12) << max_rss_mb() << '\n';
+    }
+
+    int64_t total_ns = 0;
+    for (size_t phase = 0; phase < Phases::COUNT; ++phase) {
+        total_ns += phases.ns[phase];
+    }
+    const double row_sweeps = 1.0 * row_count * sweep_count;
+    std::cout << '\n' <<
+        std::setw(8) << "phase" <<
+        std::setw(12) << "ns/row" <<
+        std::setw(8) << "share" << '\n';
+    for (size_t phase = 0; phase < Phases::COUNT; ++phase) {
+        std::cout <<
+            std::setw(8) << Phases::name(phase) <<
+            std::fixed << std::setprecision(1) <<
+            std::setw(12) << phases.ns[phase] / row_sweeps <<
+            std::setw(7) << 100.0 * phases.ns[phase] / total_ns << "%\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,326 @@
+// Copyright (c) 2014, Salesforce.com, Inc.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+// - Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// - Neither the name of Salesforce.com nor the names of its contributors
+//   may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+// COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+// OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+// TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <distributions/common.hpp>
+#include <distributions/timers.hpp>
+#ifdef __linux__
+#  include <sched.h>
+#endif  // __linux__
+
+// A small harness for stable microbenchmarks:
+// each benchmark is calibrated to run for at least min_time seconds per
+// trial, warmed up, then timed over repeated trials, reporting order
+// statistics of nanoseconds per item. Results can be written as JSON and
+// compared against a previous JSON run to catch regressions.
+
+namespace distributions {
+namespace benchmark {
+
+// Benchmarks should pass results or modified state through these,
+// so that the compiler cannot optimize the work away.
+inline void escape(const void * pointer) {
+    asm volatile("" : : "g"(pointer) : "memory");
+}
+
+inline void consume(float value) {
+    escape(&value);
+}
+
+struct Options {
+    size_t warmup = 2;
+    size_t trials = 15;
+    double min_time = 0.01;
+    int cpu = 0;
+    std::string filter;
+    std::string json;
+    std::string baseline;
+    double tolerance = 0.1;
+
+    static void usage(const char * program) {
+        std::cerr <<
+            "Usage: " << program << " [options]\n"
+            "  --warmup=N     untimed trials before timing (default 2)\n"
+            "  --trials=N     timed trials (default 15)\n"
+            "  --min-time=S   minimum seconds per trial (default 0.01)\n"
+            "  --cpu=N        pin to cpu N, or -1 to not pin (default 0)\n"
+            "  --filter=S     run only benchmarks whose name contains S\n"
+            "  --json=FILE    write results as JSON\n"
+            "  --baseline=FILE  compare medians against a JSON result\n"
+            "  --tolerance=F  relative slowdown counted as a regression\n"
+            "                 (default 0.1)\n";
+    }
+
+    Options(int argc, char ** argv) {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const size_t eq = arg.find('=');
+            const std::string key = arg.substr(0, eq);
+            const std::string value =
+                (eq == std::string::npos) ? "" : arg.substr(eq + 1);
+            if (key == "--warmup") {
+                warmup = atoi(value.c_str());
+            } else if (key == "--trials") {
+                trials = atoi(value.c_str());
+            } else if (key == "--min-time") {
+                min_time = atof(value.c_str());
+            } else if (key == "--cpu") {
+                cpu = atoi(value.c_str());
+            } else if (key == "--filter") {
+                filter = value;
+            } else if (key == "--json") {
+                json = value;
+            } else if (key == "--baseline") {
+                baseline = value;
+            } else if (key == "--tolerance") {
+                tolerance = atof(value.c_str());
+            } else {
+                usage(argv[0]);
+                exit(key == "--help" ? 0 : 1);
+            }
+        }
+        DIST_ASSERT(trials > 0, "trials must be positive");
+    }
+};
+
+struct Result {
+    std::string name;
+    size_t items;
+    size_t iters;
+    size_t trials;
+    double min;
+    double p10;
+    double median;
+    double p90;
+};
+
+// nearest-rank percentile of a sorted vector
+inline double percentile(const std::vector<double> & sorted, double p) {
+    const size_t rank = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[rank];
+}
+
+// Pins the calling thread, returning false on failure.
+inline bool pin_to_cpu(int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else  // __linux__
+    return false;
+#endif  // __linux__
+}
+
+// Reads medians keyed by name from a file written by Harness::write_json.
+// This relies on write_json emitting one benchmark per line.
+inline std::map<std::string, double> read_baseline(
+        const std::string & filename) {
+    std::ifstream file(filename.c_str());
+    DIST_ASSERT(file, "failed to open baseline " << filename);
+    std::map<std::string, double> medians;
+    std::string line;
+    const std::string name_key = "\"name\": \"";
+    const std::string median_key = "\"median\": ";
+    while (std::getline(file, line)) {
+        const size_t name_pos = line.find(name_key);
+        const size_t median_pos = line.find(median_key);
+        if (name_pos != std::string::npos and
+                median_pos != std::string::npos) {
+            const size_t begin = name_pos + name_key.size();
+            const size_t end = line.find('"', begin);
+            const std::string name = line.substr(begin, end - begin);
+            const char * median = line.c_str() + median_pos
+                                + median_key.size();
+            medians[name] = strtod(median, nullptr);
+        }
+    }
+    return medians;
+}
+
+class Harness {
+  public:
+    typedef std::function<void()> Fun;
+
+    explicit Harness(const Options & options) : options_(options) {}
+
+    // items counts the units of work done by one call of fun,
+    // so that results are reported per item.
+    void add(const std::string & name, size_t items, Fun fun) {
+        if (name.find(options_.filter) != std::string::npos) {
+            benchmarks_.push_back(Benchmark({name, items, fun}));
+        }
+    }
+
+    // Returns a process exit status: nonzero iff a regression was found.
+    int run() {
+        if (options_.cpu >= 0 and not pin_to_cpu(options_.cpu)) {
+            std::cerr << "WARNING failed to pin to cpu " << options_.cpu <<
+                '\n';
+        }
+
+        std::map<std::string, double> baseline;
+        if (not options_.baseline.empty()) {
+            baseline = read_baseline(options_.baseline);
+        }
+
+        std::cout << std::left << std::setw(44) << "benchmark" <<
+            std::right <<
+            std::setw(11) << "median ns" <<
+            std::setw(11) << "p10 ns" <<
+            std::setw(11) << "p90 ns";
+        if (not baseline.empty()) {
+            std::cout <<
+                std::setw(11) << "base ns" <<
+                std::setw(9) << "change";
+        }
+        std::cout << '\n';
+
+        size_t regression_count = 0;
+        for (const auto & benchmark : benchmarks_) {
+            const Result result = measure(benchmark);
+            results_.push_back(result);
+            std::cout << std::left << std::setw(44) << result.name <<
+                std::right << std::fixed << std::setprecision(2) <<
+                std::setw(11) << result.median <<
+                std::setw(11) << result.p10 <<
+                std::setw(11) << result.p90;
+            auto i = baseline.find(result.name);
+            if (i != baseline.end()) {
+                const double change = result.median / i->second - 1;
+                std::cout << std::setw(11) << i->second <<
+                    std::setw(8) << std::setprecision(1) <<
+                    100 * change << '%';
+                if (change > options_.tolerance) {
+                    std::cout << " REGRESSION";
+                    ++regression_count;
+                }
+            }
+            std::cout << '\n';
+        }
+
+        if (not options_.json.empty()) {
+            write_json(options_.json);
+        }
+        if (regression_count) {
+            std::cout << regression_count << " regressions\n";
+        }
+        return regression_count ? 1 : 0;
+    }
+
+    const std::vector<Result> & results() const { return results_; }
+
+    void write_json(const std::string & filename) const {
+        std::ofstream file(filename.c_str());
+        DIST_ASSERT(file, "failed to open " << filename);
+        file << std::setprecision(6) <<
+            "{\n" <<
+            "  \"unit\": \"ns per item\",\n" <<
+            "  \"trials\": " << options_.trials << ",\n" <<
+            "  \"benchmarks\": [\n";
+        for (size_t i = 0; i < results_.size(); ++i) {
+            const Result & result = results_[i];
+            file <<
+                "    {\"name\": \"" << result.name << "\", " <<
+                "\"items\": " << result.items << ", " <<
+                "\"iters\": " << result.iters << ", " <<
+                "\"min\": " << result.min << ", " <<
+                "\"p10\": " << result.p10 << ", " <<
+                "\"median\": " << result.median << ", " <<
+                "\"p90\": " << result.p90 << "}" <<
+                (i + 1 < results_.size() ? ",\n" : "\n");
+        }
+        file << "  ]\n}\n";
+    }
+
+  private:
+    struct Benchmark {
+        std::string name;
+        size_t items;
+        Fun fun;
+    };
+
+    static int64_t time_ns(const Fun & fun, size_t iters) {
+        int64_t time = -current_time_ns();
+        for (size_t i = 0; i < iters; ++i) {
+            fun();
+        }
+        time += current_time_ns();
+        return time;
+    }
+
+    Result measure(const Benchmark & benchmark) const {
+        // calibrate, which also serves to warm caches
+        const int64_t min_time_ns = static_cast<int64_t>(
+            options_.min_time * 1e9);
+        size_t iters = 1;
+        while (time_ns(benchmark.fun, iters) < min_time_ns) {
+            iters *= 2;
+        }
+
+        for (size_t trial = 0; trial < options_.warmup; ++trial) {
+            time_ns(benchmark.fun, iters);
+        }
+
+        std::vector<double> ns_per_item;
+        const double items = 1.0 * iters * benchmark.items;
+        for (size_t trial = 0; trial < options_.trials; ++trial) {
+            ns_per_item.push_back(time_ns(benchmark.fun, iters) / items);
+        }
+        std::sort(ns_per_item.begin(), ns_per_item.end());
+
+        Result result;
+        result.name = benchmark.name;
+        result.items = benchmark.items;
+        result.iters = iters;
+        result.trials = options_.trials;
+        result.min = ns_per_item.front();
+        result.p10 = percentile(ns_per_item, 0.1);
+        result.median = percentile(ns_per_item, 0.5);
+        result.p90 = percentile(ns_per_item, 0.9);
+        return result;
+    }
+
+    const Options options_;
+    std::vector<Benchmark> benchmarks_;
+    std::vector<Result> results_;
+};
+
+}  // namespace benchmark
+}  // namespace distributions
@@ -0,0 +1,179 @@
+// Copyright (c) 2014, Salesforce.com, Inc.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+// - Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// - Neither the name of Salesforce.com nor the names of its contributors
+//   may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+// COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+// OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+// TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <distributions/random.hpp>
+#include <distributions/timers.hpp>
+#include <distributions/io/protobuf_arena.hpp>
+#include <distributions/models/dd.hpp>
+#include <distributions/models/dpd.hpp>
+#include <distributions/models/gp.hpp>
+#include <distributions/models/nich.hpp>
+#include <distributions/models/niw.hpp>
+
+using namespace distributions;  // NOLINT(*)
+namespace pb = distributions::protobuf;
+
+template<class Model, class SharedMessage, class GroupMessage>
+void speedtest(
+        const std::string & name,
+        size_t group_count,
+        size_t values_per_group,
+        size_t iters,
+        const std::string & filename) {
+    typedef typename Model::Group Group;
+    auto const shared = Model::Shared::EXAMPLE();
+
+    // draw values from the prior predictive, since repeatedly sampling
+    // from a posterior can make NIW covariances singular in float
+    rng_t rng;
+    Group empty;
+    empty.init(shared, rng);
+    typename Model::Sampler sampler;
+    sampler.init(shared, empty, rng);
+    std::vector<Group> groups(group_count);
+    for (auto & group : groups) {
+        group.init(shared, rng);
+        for (size_t i = 0; i < values_per_group; ++i) {
+            group.add_value(shared, sampler.eval(shared, rng), rng);
+        }
+    }
+
+    // baseline: fresh messages for every checkpoint
+    size_t bytes = 0;
+    int64_t fresh_time = -current_time_us();
+    for (size_t iter = 0; iter < iters; ++iter) {
+        std::vector<GroupMessage> messages(group_count);
+        for (size_t i = 0; i < group_count; ++i) {
+            groups[i].protobuf_dump(messages[i]);
+        }
+        bytes = 0;
+        for (const auto & message : messages) {
+            bytes += message.ByteSizeLong();
+        }
+    }
+    fresh_time += current_time_us();
+
+    pb::ArenaDumper<Model, SharedMessage, GroupMessage> dumper;
+    int64_t arena_time = -current_time_us();
+    for (size_t iter = 0; iter < iters; ++iter) {
+        dumper.dump(shared, groups);
+    }
+    arena_time += current_time_us();
+
+    int64_t write_time = -current_time_us();
+    for (size_t iter = 0; iter < iters; ++iter) {
+        pb::OutFile file(filename);
+        dumper.write(file);
+        file.close();
+    }
+    write_time += current_time_us();
+
+    pb::ArenaDumper<Model, SharedMessage, GroupMessage> loader;
+    typename Model::Shared shared2;
+    std::vector<Group> groups2;
+    int64_t read_time = -current_time_us();
+    for (size_t iter = 0; iter < iters; ++iter) {
+        pb::InFile file(filename);
+        loader.read(file);
+        loader.load(shared2, groups2);
+    }
+    read_time += current_time_us();
+    DIST_ASSERT_EQ(groups2.size(), group_count);
+    remove(filename.c_str());
+
+    const double total_groups = 1.0 * group_count * iters;
+    const double total_mb = 1e-6 * bytes * iters;
+    auto groups_per_sec = [&](int64_t time) {
+        return total_groups / (time * 1e-6);
+    };
+    auto mb_per_sec = [&](int64_t time) {
+        return total_mb / (time * 1e-6);
+    };
+
+    std::cout << std::setw(12) << std::left << name <<
+        std::right << std::fixed << std::setprecision(1) <<
+        std::setw(14) << groups_per_sec(fresh_time) <<
+        std::setw(14) << groups_per_sec(arena_time) <<
+        std::setw(12) << mb_per_sec(arena_time) <<
+        std::setw(12) << mb_per_sec(write_time) <<
+        std::setw(12) << mb_per_sec(read_time) << '\n';
+}
+
+int main(int argc, char ** argv) {
+    const size_t group_count = (argc > 1) ? atoi(argv[1]) : 100000;
+    const size_t values_per_group = (argc > 2) ? atoi(argv[2]) : 10;
+    const std::string filename =
+        (argc > 3) ? argv[3] : "/tmp/protobuf_dump.pbs";
+    const size_t iters = 5;
+
+    std::cout <<
+        group_count << " groups, " <<
+        values_per_group << " values per group\n" <<
+        std::setw(12) << std::left << "model" << std::right <<
+        std::setw(14) << "fresh grp/s" <<
+        std::setw(14) << "arena grp/s" <<
+        std::setw(12) << "dump MB/s" <<
+        std::setw(12) << "write MB/s" <<
+        std::setw(12) << "read MB/s" << '\n';
+
+    speedtest<
+        DirichletDiscrete<16>,
+        pb::DirichletDiscrete::Shared,
+        pb::DirichletDiscrete::Group>(
+        "dd16", group_count, values_per_group, iters, filename);
+    speedtest<
+        DirichletProcessDiscrete,
+        pb::DirichletProcessDiscrete::Shared,
+        pb::DirichletProcessDiscrete::Group>(
+        "dpd", group_count, values_per_group, iters, filename);
+    speedtest<
+        GammaPoisson,
+        pb::GammaPoisson::Shared,
+        pb::GammaPoisson::Group>(
+        "gp", group_count, values_per_group, iters, filename);
+    speedtest<
+        NormalInverseChiSq,
+        pb::NormalInverseChiSq::Shared,
+        pb::NormalInverseChiSq::Group>(
+        "nich", group_count, values_per_group, iters, filename);
+    speedtest<
+        NormalInverseWishart<3>,
+        pb::NormalInverseWishart::Shared,
+        pb::NormalInverseWishart::Group>(
+        "niw3", group_count, values_per_group, iters, filename);
+    speedtest<
+        NormalInverseWishart<-1>,
+        pb::NormalInverseWishart::Shared,
+        pb::NormalInverseWishart::Group>(
+        "niw", group_count, values_per_group, iters, filename);
+
+    return 0;
+}
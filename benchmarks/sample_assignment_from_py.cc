@@ -27,6 +27,7 @@
 
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
 #include <cstdio>
 #include <distributions/random.hpp>
 #include <distributions/clustering.hpp>
@@ -46,49 +47,65 @@ inline int max(const std::vector<int> & counts) {
     return result;
 }
 
-size_t speedtest(size_t size, size_t iters, float alpha, float d) {
-    Clustering<int>::PitmanYor model;
-    model.alpha = alpha;
-    model.d = d;
-
-    rng_t rng;
-
+template<class Sampler>
+double speedtest(size_t size, size_t iters, Sampler sample, double & cats) {
     int64_t time = -current_time_us();
 
-    size_t bogus = 0;
     double total_cats = 0;
     for (size_t i = 0; i < iters; ++i) {
-        total_cats += max(model.sample_assignments(size, rng));
+        total_cats += max(sample(size));
     }
 
     time += current_time_us();
 
     double time_sec = time * 1e-6;
-    double samples_per_sec = iters / time_sec;
-    double mean_cats = total_cats / iters;
-    std::cout <<
-        size << '\t' <<
-        std::right << std::setw(6) << std::fixed << std::setprecision(1) <<
-        mean_cats << '\t' <<
-        std::right << std::setw(12) << std::fixed << std::setprecision(1) <<
-        samples_per_sec << '\n';
-
-    return bogus;
+    cats = total_cats / iters;
+    return iters / time_sec;
 }
 
 int main(int argc, char ** argv) {
     float alpha = (argc > 1) ? atof(argv[1]) : 1.0f;
     float d = (argc > 2) ? atof(argv[2]) : 0.2f;
 
+    Clustering<int>::PitmanYor model;
+    model.alpha = alpha;
+    model.d = d;
+    rng_t rng;
+
+    auto sample = [&](size_t size) {
+        return model.sample_assignments(size, rng);
+    };
+    auto sample_fast = [&](size_t size) {
+        return model.sample_assignments_fast(size, rng);
+    };
+
     std::cout << "size" << '\t' << "cats" << '\t' << "samples/sec";
+    std::cout << '\t' << "fast samples/sec";
     std::cout << " (alpha = " << alpha << ", d = " << d << ")\n";
 
     size_t min_exponent = 3;
-    size_t max_exponent = 6;
+    size_t max_slow_exponent = 6;
+    size_t max_exponent = 8;
     for (size_t i = min_exponent; i <= max_exponent; ++i) {
         size_t size = size_t(round(pow(10, i)));
-        size_t iters = 10000000 / size;
-        speedtest(size, iters, alpha, d);
+        size_t iters = std::max(size_t(1), size_t(10000000 / size));
+        double cats = 0;
+        double fast_rate = speedtest(size, iters, sample_fast, cats);
+        std::cout <<
+            size << '\t' <<
+            std::right << std::setw(6) << std::fixed << std::setprecision(1) <<
+            cats << '\t';
+        if (i <= max_slow_exponent) {
+            double rate = speedtest(size, iters, sample, cats);
+            std::cout <<
+                std::right << std::setw(12) << std::fixed <<
+                std::setprecision(1) << rate;
+        } else {
+            std::cout << std::right << std::setw(12) << '-';
+        }
+        std::cout << '\t' <<
+            std::right << std::setw(12) << std::fixed <<
+            std::setprecision(1) << fast_rate << '\n';
     }
 
     return 0;
@@ -0,0 +1,134 @@
+// Copyright (c) 2014, Salesforce.com, Inc.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+// - Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// - Neither the name of Salesforce.com nor the names of its contributors
+//   may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+// COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+// OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+// TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <distributions/random.hpp>
+#include <distributions/vector.hpp>
+#include <distributions/models/bb.hpp>
+#include <distributions/models/dd.hpp>
+#include <distributions/models/nich.hpp>
+#include "harness.hpp"
+
+// This compares score_value on mixtures caching scores as float,
+// bfloat16_t and float16_t.  Once the cached tables outgrow the cache,
+// score_value is bound by memory bandwidth, so halving the bytes per
+// score should approach halving the time per cell.
+
+using namespace distributions;  // NOLINT(*)
+using distributions::benchmark::Harness;
+using distributions::benchmark::Options;
+using distributions::benchmark::escape;
+
+rng_t rng;
+
+const size_t value_count = 64;
+
+template<class Model, class Mixture>
+struct ScoreFixture {
+    typedef typename Model::Value Value;
+    typedef typename Model::Shared Shared;
+
+    Shared shared;
+    Mixture mixture;
+    std::vector<Value> values;
+    VectorFloat scores;
+    size_t next;
+
+    explicit ScoreFixture(size_t group_count) :
+        shared(Shared::EXAMPLE()),
+        scores(group_count, 0),
+        next(0)
+    {
+        mixture.groups().resize(group_count);
+        for (auto & group : mixture.groups()) {
+            group.init(shared, rng);
+        }
+        for (size_t i = 0; i < value_count; ++i) {
+            size_t groupid = sample_int(rng, 0, group_count - 1);
+            auto & group = mixture.groups()[groupid];
+            Value value = group.sample_value(shared, rng);
+            group.add_value(shared, value, rng);
+            values.push_back(value);
+        }
+        mixture.init(shared, rng);
+    }
+
+    void score() {
+        mixture.score_value(shared, values[next], scores, rng);
+        escape(scores.data());
+        next = (next + 1) % value_count;
+    }
+};
+
+template<class Model, class Mixture>
+void add_scores(
+        Harness & harness,
+        const std::string & model_name,
+        const std::string & score_name) {
+    for (size_t group_count = 100; group_count <= 1000000;
+            group_count *= 10) {
+        auto f = std::make_shared<ScoreFixture<Model, Mixture>>(group_count);
+        std::ostringstream name;
+        name << model_name << "_score_value/" << score_name << '/'
+             << group_count;
+        harness.add(name.str(), group_count, [f](){ f->score(); });
+        std::cerr << name.str() << ": "
+                  << f->mixture.memory_usage() << " bytes\n";
+    }
+}
+
+template<class Model>
+void add_model(Harness & harness, const std::string & model_name) {
+    add_scores<Model, typename Model::FastMixture>(
+        harness,
+        model_name,
+        "float");
+    add_scores<Model, typename Model::BFloat16Mixture>(
+        harness,
+        model_name,
+        "bfloat16");
+    add_scores<Model, typename Model::Float16Mixture>(
+        harness,
+        model_name,
+        "float16");
+}
+
+int main(int argc, char ** argv) {
+    const Options options(argc, argv);
+    Harness harness(options);
+
+    add_model<BetaBernoulli>(harness, "bb");
+    add_model<DirichletDiscrete<16>>(harness, "dd16");
+    add_model<NormalInverseChiSq>(harness, "nich");
+
+    return harness.run();
+}
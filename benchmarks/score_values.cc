@@ -0,0 +1,105 @@
+// Copyright (c) 2014, Salesforce.com, Inc.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+// - Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// - Neither the name of Salesforce.com nor the names of its contributors
+//   may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+// COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+// OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+// TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <iostream>
+#include <iomanip>
+#include <typeinfo>
+#include <distributions/vector.hpp>
+#include <distributions/models/gp.hpp>
+#include <distributions/models/nich.hpp>
+#include <distributions/timers.hpp>
+
+using namespace distributions;  // NOLINT(*)
+
+rng_t rng;
+
+template<class Model>
+void speedtest(
+        const typename Model::Shared & shared,
+        size_t value_count,
+        size_t group_count) {
+    typename Model::Mixture mixture;
+    mixture.groups().resize(group_count);
+    for (auto & group : mixture.groups()) {
+        group.init(shared, rng);
+    }
+    std::vector<typename Model::Value> values;
+    for (size_t i = 0; i < value_count; ++i) {
+        size_t groupid = sample_int(rng, 0, group_count - 1);
+        typename Model::Group & group = mixture.groups()[groupid];
+        typename Model::Value value = group.sample_value(shared, rng);
+        group.add_value(shared, value, rng);
+        values.push_back(value);
+    }
+    mixture.init(shared, rng);
+
+    std::vector<VectorFloat> rows(value_count, VectorFloat(group_count, 0));
+    VectorFloat scores(value_count * group_count, 0);
+
+    int64_t time = -current_time_us();
+    for (size_t i = 0; i < value_count; ++i) {
+        mixture.score_value(shared, values[i], rows[i], rng);
+    }
+    time += current_time_us();
+    double score_value_rate = value_count * group_count * 1e0 / time;
+
+    time = -current_time_us();
+    mixture.score_values(shared, values, scores, rng);
+    time += current_time_us();
+    double score_values_rate = value_count * group_count * 1e0 / time;
+
+    std::cout <<
+        value_count << '\t' <<
+        group_count << '\t' <<
+        std::right << std::setw(7) << std::fixed << std::setprecision(1) <<
+        score_value_rate << '\t' <<
+        std::right << std::setw(7) << std::fixed << std::setprecision(1) <<
+        score_values_rate << '\n';
+}
+
+template<class Model>
+void speedtests() {
+    std::cout <<
+        demangle(typeid(typename Model::Shared).name()) << '\n' <<
+        "Values" << '\t' <<
+        "Groups" << '\t' <<
+        "score_value" << '\t' <<
+        "score_values (evals/us)" << '\n';
+
+    auto const shared = Model::Shared::EXAMPLE();
+    const size_t value_count = 10000;
+    for (size_t group_count = 10; group_count <= 1000; group_count *= 10) {
+        speedtest<Model>(shared, value_count, group_count);
+    }
+}
+
+int main() {
+    speedtests<GammaPoisson>();
+    speedtests<NormalInverseChiSq>();
+
+    return 0;
+}
@@ -0,0 +1,346 @@
+// Copyright (c) 2014, Salesforce.com, Inc.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+// - Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// - Neither the name of Salesforce.com nor the names of its contributors
+//   may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+// COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+// OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+// TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <typeinfo>
+#include <vector>
+#include <distributions/random.hpp>
+#include <distributions/special.hpp>
+#include <distributions/vector.hpp>
+#include <distributions/vector_math.hpp>
+#include <distributions/clustering.hpp>
+#include <distributions/models/bb.hpp>
+#include <distributions/models/bnb.hpp>
+#include <distributions/models/dd.hpp>
+#include <distributions/models/dpd.hpp>
+#include <distributions/models/gp.hpp>
+#include <distributions/models/nich.hpp>
+#include <distributions/models/niw.hpp>
+#include "harness.hpp"
+
+using namespace distributions;  // NOLINT(*)
+using distributions::benchmark::Harness;
+using distributions::benchmark::Options;
+using distributions::benchmark::consume;
+using distributions::benchmark::escape;
+
+rng_t rng;
+
+//----------------------------------------------------------------------------
+// vector_math kernels
+
+struct VectorFixture {
+    VectorFloat in1;
+    VectorFloat in2;
+    VectorFloat out;
+
+    explicit VectorFixture(size_t size) : in1(size), in2(size), out(size) {
+        std::uniform_real_distribution<float> sample(1.f, 10.f);
+        for (size_t i = 0; i < size; ++i) {
+            in1[i] = sample(rng);
+            in2[i] = sample(rng);
+            out[i] = sample(rng);
+        }
+    }
+};
+
+void add_vector_math(Harness & harness, size_t size) {
+    auto f = std::make_shared<VectorFixture>(size);
+    std::ostringstream suffix;
+    suffix << '/' << size;
+    auto add = [&](const std::string & name, Harness::Fun fun) {
+        harness.add("vector_" + name + suffix.str(), size, fun);
+    };
+
+    // io kernels run on out, which only drifts slowly under repetition
+    add("zero", [f, size](){ vector_zero(size, f->out.data()); });
+    add("min", [f, size](){ consume(vector_min(size, f->in1.data())); });
+    add("max", [f, size](){ consume(vector_max(size, f->in1.data())); });
+    add("sum", [f, size](){ consume(vector_sum(size, f->in1.data())); });
+    add("dot", [f, size](){
+        consume(vector_dot(size, f->in1.data(), f->in2.data()));
+    });
+    add("shift", [f, size](){ vector_shift(size, f->out.data(), 0.f); });
+    add("scale", [f, size](){ vector_scale(size, f->out.data(), 1.f); });
+    add("negate", [f, size](){ vector_negate(size, f->out.data()); });
+    add("add", [f, size](){
+        vector_add(size, f->out.data(), f->in1.data());
+    });
+    add("negate_and_add", [f, size](){
+        vector_negate_and_add(size, f->out.data(), f->in1.data());
+    });
+    add("add_add", [f, size](){
+        vector_add_add(size, f->out.data(), f->in1.data(), f->in2.data());
+    });
+    add("add_subtract", [f, size](){
+        vector_add_subtract(
+            size,
+            f->out.data(),
+            f->in1.data(),
+            f->in2.data());
+    });
+    add("add_subtract_scalar", [f, size](){
+        vector_add_subtract(size, f->out.data(), 1.f, f->in2.data());
+    });
+    add("multiply_add", [f, size](){
+        vector_multiply_add(
+            size,
+            f->out.data(),
+            f->in1.data(),
+            f->in2.data());
+    });
+    add("exp", [f, size](){
+        vector_exp(size, f->in1.data(), f->out.data());
+    });
+    add("log", [f, size](){
+        vector_log(size, f->in1.data(), f->out.data());
+    });
+    add("lgamma", [f, size](){
+        vector_lgamma(size, f->in1.data(), f->out.data());
+    });
+    add("lgamma_nu", [f, size](){
+        vector_lgamma_nu(size, f->in1.data(), f->out.data());
+    });
+}
+
+//----------------------------------------------------------------------------
+// special functions
+
+template<class Fun>
+void add_special(
+        Harness & harness,
+        const std::string & name,
+        std::shared_ptr<VectorFixture> f,
+        Fun fun) {
+    const size_t size = f->in1.size();
+    harness.add("special_" + name, size, [f, size, fun](){
+        float total = 0;
+        const float * in = f->in1.data();
+        for (size_t i = 0; i < size; ++i) {
+            total += fun(in[i]);
+        }
+        consume(total);
+    });
+}
+
+void add_specials(Harness & harness) {
+    auto f = std::make_shared<VectorFixture>(1024);
+    add_special(harness, "fast_log", f, [](float x){ return fast_log(x); });
+    add_special(harness, "fast_exp", f, [](float x){ return fast_exp(x); });
+    add_special(harness, "eric_log", f, [](float x){ return eric_log(x); });
+    add_special(harness, "fast_lgamma", f, [](float x){
+        return fast_lgamma(x);
+    });
+    add_special(harness, "fast_lgamma_nu", f, [](float x){
+        return fast_lgamma_nu(x);
+    });
+    add_special(harness, "fast_log_factorial", f, [](float x){
+        return fast_log_factorial(static_cast<uint32_t>(x));
+    });
+    add_special(harness, "fast_log_sum_exp", f, [](float x){
+        return fast_log_sum_exp(x, 1.f);
+    });
+    add_special(harness, "fast_log_beta", f, [](float x){
+        return fast_log_beta(x, 2.f);
+    });
+    add_special(harness, "lmultigamma", f, [](float x){
+        return lmultigamma(3, x + 1.f);
+    });
+}
+
+//----------------------------------------------------------------------------
+// models
+
+template<class Model>
+struct ModelFixture {
+    typedef typename Model::Value Value;
+    typedef typename Model::Group Group;
+
+    typename Model::Shared shared;
+    Group group;
+    typename Model::Scorer scorer;
+    typename Model::Mixture mixture;
+    std::vector<Value> values;
+    std::vector<size_t> assignments;
+    VectorFloat scores;
+
+    ModelFixture(size_t group_count, size_t value_count) :
+        shared(Model::Shared::EXAMPLE()) {
+        // draw values from the prior predictive, since repeatedly sampling
+        // from a posterior can make NIW covariances singular in float
+        Group empty;
+        empty.init(shared, rng);
+        typename Model::Sampler sampler;
+        sampler.init(shared, empty, rng);
+
+        group.init(shared, rng);
+        mixture.groups().resize(group_count);
+        for (auto & group : mixture.groups()) {
+            group.init(shared, rng);
+        }
+        for (size_t i = 0; i < value_count; ++i) {
+            const Value value = sampler.eval(shared, rng);
+            const size_t groupid = sample_int(rng, 0, group_count - 1);
+            group.add_value(shared, value, rng);
+            mixture.groups(groupid).add_value(shared, value, rng);
+            values.push_back(value);
+            assignments.push_back(groupid);
+        }
+        mixture.init(shared, rng);
+        scorer.init(shared, group, rng);
+        scores.resize(group_count);
+    }
+};
+
+const size_t value_count = 256;
+
+template<class Model>
+void add_group(Harness & harness, const std::string & model_name) {
+    auto f = std::make_shared<ModelFixture<Model>>(1, value_count);
+    auto add = [&](const std::string & name, size_t items, Harness::Fun fun) {
+        harness.add(model_name + '/' + name, items, fun);
+    };
+
+    add("group_score_value", value_count, [f](){
+        float total = 0;
+        for (const auto & value : f->values) {
+            total += f->group.score_value(f->shared, value, rng);
+        }
+        consume(total);
+    });
+    add("group_add_remove_value", value_count, [f](){
+        for (const auto & value : f->values) {
+            f->group.add_value(f->shared, value, rng);
+            escape(&f->group);
+            f->group.remove_value(f->shared, value, rng);
+            escape(&f->group);
+        }
+    });
+    add("group_score_data", 1, [f](){
+        consume(f->group.score_data(f->shared, rng));
+    });
+    add("scorer_init", 1, [f](){
+        f->scorer.init(f->shared, f->group, rng);
+    });
+    add("scorer_eval", value_count, [f](){
+        float total = 0;
+        for (const auto & value : f->values) {
+            total += f->scorer.eval(f->shared, value, rng);
+        }
+        consume(total);
+    });
+}
+
+template<class Model>
+void add_mixture(
+        Harness & harness,
+        const std::string & model_name,
+        size_t group_count) {
+    auto f = std::make_shared<ModelFixture<Model>>(group_count, value_count);
+    std::ostringstream prefix;
+    prefix << model_name << '/' << group_count << '/';
+    auto add = [&](const std::string & name, size_t items, Harness::Fun fun) {
+        harness.add(prefix.str() + name, items, fun);
+    };
+
+    // mixture items are cells, i.e. (value, group) pairs
+    add("mixture_score_value", value_count * group_count, [f](){
+        for (const auto & value : f->values) {
+            vector_zero(f->scores.size(), f->scores.data());
+            f->mixture.score_value(f->shared, value, f->scores, rng);
+        }
+        consume(f->scores[0]);
+    });
+    add("mixture_remove_add_value", value_count, [f](){
+        for (size_t i = 0, size = f->values.size(); i < size; ++i) {
+            const auto & value = f->values[i];
+            const size_t groupid = f->assignments[i];
+            f->mixture.remove_value(f->shared, groupid, value, rng);
+            f->mixture.add_value(f->shared, groupid, value, rng);
+        }
+    });
+    add("mixture_score_data", group_count, [f](){
+        consume(f->mixture.score_data(f->shared, rng));
+    });
+}
+
+template<class Model>
+void add_model(Harness & harness, const std::string & model_name) {
+    add_group<Model>(harness, model_name);
+    for (size_t group_count = 10; group_count <= 1000; group_count *= 10) {
+        add_mixture<Model>(harness, model_name, group_count);
+    }
+}
+
+//----------------------------------------------------------------------------
+// clustering
+
+void add_clustering(Harness & harness) {
+    typedef Clustering<int>::PitmanYor PitmanYor;
+    auto model = std::make_shared<PitmanYor>();
+    model->alpha = 1.f;
+    model->d = 0.2f;
+    auto counts = std::make_shared<std::vector<int>>(
+        Clustering<int>::count_assignments(
+            model->sample_assignments_fast(10000, rng)));
+    harness.add("pitman_yor/score_counts", counts->size(), [model, counts](){
+        consume(model->score_counts(*counts));
+    });
+
+    auto mixture = std::make_shared<PitmanYor::Mixture>();
+    mixture->counts() = *counts;
+    mixture->counts().push_back(0);
+    mixture->init(*model);
+    auto scores = std::make_shared<VectorFloat>(mixture->counts().size());
+    harness.add("pitman_yor/mixture_score_value", scores->size(),
+            [model, mixture, scores](){
+        mixture->score_value(*model, *scores);
+        consume((*scores)[0]);
+    });
+}
+
+int main(int argc, char ** argv) {
+    const Options options(argc, argv);
+    Harness harness(options);
+
+    add_vector_math(harness, 16);
+    add_vector_math(harness, 1024);
+    add_specials(harness);
+    add_model<BetaBernoulli>(harness, "bb");
+    add_model<BetaNegativeBinomial>(harness, "bnb");
+    add_model<DirichletDiscrete<4>>(harness, "dd4");
+    add_model<DirichletDiscrete<256>>(harness, "dd256");
+    add_model<DirichletProcessDiscrete>(harness, "dpd");
+    add_model<GammaPoisson>(harness, "gp");
+    add_model<NormalInverseChiSq>(harness, "nich");
+    add_model<NormalInverseWishart<3>>(harness, "niw3");
+    add_clustering(harness);
+
+    return harness.run();
+}
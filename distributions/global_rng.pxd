@@ -29,3 +29,6 @@ from rng_cc cimport rng_t
 
 
 cdef rng_t * get_rng()
+
+# returns the global rng if rng is None, else the RngCc rng
+cdef rng_t * get_rng_or_global(rng)
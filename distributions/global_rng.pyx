@@ -31,3 +31,10 @@ cimport distributions.rng_cc
 
 cdef rng_t * get_rng():
     return distributions.rng_cc.extract_rng(distributions.rng.global_rng.cc)
+
+
+cdef rng_t * get_rng_or_global(rng):
+    if rng is None:
+        return get_rng()
+    else:
+        return distributions.rng_cc.extract_rng(rng)
@@ -27,6 +27,7 @@
 
 from libcpp.vector cimport vector
 from libcpp.utility cimport pair
+import numpy
 cimport numpy
 numpy.import_array()
 from cython import address
@@ -62,11 +63,19 @@ cdef extern from 'distributions/clustering.hpp':
     cdef vector[int] count_assignments_cc \
             "distributions::Clustering<int>::count_assignments" \
             (Assignments & assignments) nogil except +
+    cdef vector[int] count_assignment_array_cc \
+            "distributions::Clustering<int>::count_assignments" \
+            (int * assignments, size_t size) nogil except +
 
     cppclass PitmanYor_cc "distributions::Clustering<int>::PitmanYor":
         float alpha
         float d
         vector[int] sample_assignments(int size, rng_t & rng) nogil except +
+        void sample_assignment_array "sample_assignments" \
+                (int size, int * assignments, rng_t & rng) nogil except +
+        vector[int] sample_counts(int size, rng_t & rng) nogil except +
+        vector[int] sample_assignments_fast(int size, rng_t & rng) \
+                nogil except +
         cppclass Mixture:
             size_t size "counts().size" () nogil except +
             IdSet.iterator empty_groupids_begin \
@@ -78,7 +87,11 @@ cdef extern from 'distributions/clustering.hpp':
             bint add_value (PitmanYor_cc &, size_t) nogil except +
             bint remove_value (PitmanYor_cc &, size_t) nogil except +
             void score_value (PitmanYor_cc &, VectorFloat &) nogil except +
+            void score_value_unnormalized (PitmanYor_cc &, VectorFloat &) \
+                    nogil except +
         float score_counts(vector[int] & counts) nogil except +
+        float score_assignments(int * assignments, size_t size) \
+                nogil except +
         float score_add_value (
                 int group_size,
                 int nonempty_group_count,
@@ -93,6 +106,8 @@ cdef extern from 'distributions/clustering.hpp':
     cppclass LowEntropy_cc "distributions::Clustering<int>::LowEntropy":
         int dataset_size
         vector[int] sample_assignments(int size, rng_t & rng) nogil except +
+        void sample_assignment_array "sample_assignments" \
+                (int size, int * assignments, rng_t & rng) nogil except +
         cppclass Mixture:
             size_t size "counts().size" () nogil except +
             IdSet.iterator empty_groupids_begin \
@@ -104,7 +119,11 @@ cdef extern from 'distributions/clustering.hpp':
             bint add_value (LowEntropy_cc &, size_t) nogil except +
             bint remove_value (LowEntropy_cc &, size_t) nogil except +
             void score_value (LowEntropy_cc &, VectorFloat &) nogil except +
+            void score_value_unnormalized (LowEntropy_cc &, VectorFloat &) \
+                    nogil except +
         float score_counts(vector[int] & counts) nogil except +
+        float score_assignments(int * assignments, size_t size) \
+                nogil except +
         float score_add_value (
                 int group_size,
                 int nonempty_group_count,
@@ -116,8 +135,35 @@ cdef extern from 'distributions/clustering.hpp':
                 int sample_size,
                 int empty_group_count) nogil except +
 
+    cdef void pitman_yor_score_counts_grid_cc \
+            "distributions::Clustering<int>::PitmanYor::score_counts_grid" \
+            (vector[PitmanYor_cc] & models,
+             vector[int] & counts,
+             VectorFloat & scores_out) nogil except +
+    cdef void low_entropy_score_counts_grid_cc \
+            "distributions::Clustering<int>::LowEntropy::score_counts_grid" \
+            (vector[LowEntropy_cc] & models,
+             vector[int] & counts,
+             VectorFloat & scores_out) nogil except +
+
+
+cpdef list count_assignments(assignments):
+    '''
+    Count group sizes of either a dict mapping value ids to group ids,
+    or an array of group ids indexed by row. int32 arrays are not copied.
+    '''
+    if isinstance(assignments, dict):
+        return count_assignment_dict(assignments)
+    cdef numpy.ndarray[numpy.int32_t, ndim=1] array = \
+        assignment_array(assignments)
+    cdef size_t size = len(array)
+    cdef vector[int] counts
+    with nogil:
+        counts = count_assignment_array_cc(<int *> array.data, size)
+    return counts
+
 
-cpdef list count_assignments(dict assignments):
+cdef list count_assignment_dict(dict assignments):
     cdef Assignments assignments_cc
     cdef int value_id
     cdef int group_id
@@ -127,6 +173,10 @@ cpdef list count_assignments(dict assignments):
     return counts
 
 
+cdef numpy.ndarray assignment_array(assignments):
+    return numpy.ascontiguousarray(assignments, dtype=numpy.int32)
+
+
 cdef dict dump_assignments(Assignments & assignments):
     cdef dict raw = {}
     cdef Assignments.iterator i = assignments.begin()
@@ -179,11 +229,60 @@ cdef class PitmanYor_cy:
         cdef list assignments = self.ptr.sample_assignments(size, get_rng()[0])
         return assignments
 
+    def sample_assignment_array(self, int size):
+        cdef numpy.ndarray[numpy.int32_t, ndim=1] assignments = \
+            numpy.empty(size, dtype=numpy.int32)
+        cdef rng_t * rng = get_rng()
+        with nogil:
+            self.ptr.sample_assignment_array(
+                size,
+                <int *> assignments.data,
+                rng[0])
+        return assignments
+
+    def sample_counts(self, int size):
+        cdef list counts = self.ptr.sample_counts(size, get_rng()[0])
+        return counts
+
+    def sample_assignments_fast(self, int size):
+        cdef list assignments = \
+            self.ptr.sample_assignments_fast(size, get_rng()[0])
+        return assignments
+
     def score_counts(self, list counts):
         cdef vector[int] counts_cc = counts
         cdef float score = self.ptr.score_counts(counts_cc)
         return score
 
+    @staticmethod
+    def score_counts_grid(list models, list counts):
+        '''
+        Score counts under each of many models, as an array equal to
+        [model.score_counts(counts) for model in models].
+        '''
+        cdef vector[PitmanYor_cc] models_cc
+        cdef PitmanYor_cy model
+        for model in models:
+            models_cc.push_back(model.ptr[0])
+        cdef vector[int] counts_cc = counts
+        cdef VectorFloat scores_cc
+        scores_cc.resize(models_cc.size())
+        with nogil:
+            pitman_yor_score_counts_grid_cc(models_cc, counts_cc, scores_cc)
+        cdef numpy.ndarray[numpy.float32_t, ndim=1] scores = \
+            numpy.empty(models_cc.size(), dtype=numpy.float32)
+        vector_float_to_ndarray(scores_cc, scores)
+        return scores
+
+    def score_assignments(self, assignments):
+        cdef numpy.ndarray[numpy.int32_t, ndim=1] array = \
+            assignment_array(assignments)
+        cdef size_t size = len(array)
+        cdef float score
+        with nogil:
+            score = self.ptr.score_assignments(<int *> array.data, size)
+        return score
+
     def score_add_value(
             self,
             int group_size,
@@ -256,6 +355,15 @@ cdef class PitmanYorMixture:
         self.ptr.score_value(model.ptr[0], scores_cc)
         vector_float_to_ndarray(scores_cc, scores)
 
+    def score_value_unnormalized(
+            self,
+            PitmanYor_cy model,
+            numpy.ndarray[numpy.float32_t, ndim=1] scores):
+        cdef VectorFloat scores_cc
+        scores_cc.resize(self.ptr.size())
+        self.ptr.score_value_unnormalized(model.ptr[0], scores_cc)
+        vector_float_to_ndarray(scores_cc, scores)
+
 
 class PitmanYor(PitmanYor_cy, SharedIoMixin):
 
@@ -303,11 +411,51 @@ cdef class LowEntropy_cy:
         cdef list assignments = self.ptr.sample_assignments(size, get_rng()[0])
         return assignments
 
+    def sample_assignment_array(self, int size):
+        cdef numpy.ndarray[numpy.int32_t, ndim=1] assignments = \
+            numpy.empty(size, dtype=numpy.int32)
+        cdef rng_t * rng = get_rng()
+        with nogil:
+            self.ptr.sample_assignment_array(
+                size,
+                <int *> assignments.data,
+                rng[0])
+        return assignments
+
     def score_counts(self, list counts):
         cdef vector[int] counts_cc = counts
         cdef float score = self.ptr.score_counts(counts_cc)
         return score
 
+    @staticmethod
+    def score_counts_grid(list models, list counts):
+        '''
+        Score counts under each of many models, as an array equal to
+        [model.score_counts(counts) for model in models].
+        '''
+        cdef vector[LowEntropy_cc] models_cc
+        cdef LowEntropy_cy model
+        for model in models:
+            models_cc.push_back(model.ptr[0])
+        cdef vector[int] counts_cc = counts
+        cdef VectorFloat scores_cc
+        scores_cc.resize(models_cc.size())
+        with nogil:
+            low_entropy_score_counts_grid_cc(models_cc, counts_cc, scores_cc)
+        cdef numpy.ndarray[numpy.float32_t, ndim=1] scores = \
+            numpy.empty(models_cc.size(), dtype=numpy.float32)
+        vector_float_to_ndarray(scores_cc, scores)
+        return scores
+
+    def score_assignments(self, assignments):
+        cdef numpy.ndarray[numpy.int32_t, ndim=1] array = \
+            assignment_array(assignments)
+        cdef size_t size = len(array)
+        cdef float score
+        with nogil:
+            score = self.ptr.score_assignments(<int *> array.data, size)
+        return score
+
     def score_add_value(
             self,
             int group_size,
@@ -379,6 +527,15 @@ cdef class LowEntropyMixture:
         self.ptr.score_value(model.ptr[0], scores_cc)
         vector_float_to_ndarray(scores_cc, scores)
 
+    def score_value_unnormalized(
+            self,
+            LowEntropy_cy model,
+            numpy.ndarray[numpy.float32_t, ndim=1] scores):
+        cdef VectorFloat scores_cc
+        scores_cc.resize(self.ptr.size())
+        self.ptr.score_value_unnormalized(model.ptr[0], scores_cc)
+        vector_float_to_ndarray(scores_cc, scores)
+
 
 class LowEntropy(LowEntropy_cy, SharedIoMixin):
 
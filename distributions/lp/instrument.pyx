@@ -0,0 +1,88 @@
+# Copyright (c) 2014, Salesforce.com, Inc.  All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#
+# - Redistributions of source code must retain the above copyright
+#   notice, this list of conditions and the following disclaimer.
+# - Redistributions in binary form must reproduce the above copyright
+#   notice, this list of conditions and the following disclaimer in the
+#   documentation and/or other materials provided with the distribution.
+# - Neither the name of Salesforce.com nor the names of its contributors
+#   may be used to endorse or promote products derived from this
+#   software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+# FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+# COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+# INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+# BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+# OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+# ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+# TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+# USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+from libc.stdint cimport uint64_t
+from libcpp cimport bool
+
+
+cdef extern from "distributions/instrument.hpp" \
+        namespace "distributions::instrument":
+    ctypedef int Counter "distributions::instrument::Counter"
+    ctypedef int Timer "distributions::instrument::Timer"
+    cdef enum:
+        COUNTER_COUNT
+        TIMER_COUNT
+        HISTOGRAM_SIZE
+    cdef const char * counter_name(Counter counter)
+    cdef const char * timer_name(Timer timer)
+    # arrays are declared as pointers, since cython needs constant sizes
+    cdef cppclass TimerStats:
+        uint64_t count
+        uint64_t ticks
+        uint64_t * histogram
+    cdef cppclass Stats:
+        bool enabled
+        double ticks_per_sec
+        uint64_t * counts
+        TimerStats * timers
+    cdef Stats _snapshot "distributions::instrument::snapshot" () nogil
+    cdef void _reset "distributions::instrument::reset" () nogil
+
+
+def snapshot():
+    '''
+    Return instrumentation totals over all threads, as a dict with keys
+    'enabled', 'ticks_per_sec', 'counts' and 'timers'.  Timer entries
+    report call count, total seconds, and a histogram where bin i counts
+    calls taking [2^(i-1), 2^i) ticks.  Counts are zero unless the library
+    was built with DISTRIBUTIONS_INSTRUMENT set.
+    '''
+    cdef Stats stats = _snapshot()
+    cdef TimerStats * timer
+    cdef int i
+    cdef int j
+    counts = {}
+    for i in xrange(COUNTER_COUNT):
+        counts[counter_name(<Counter> i)] = stats.counts[i]
+    timers = {}
+    for i in xrange(TIMER_COUNT):
+        timer = & stats.timers[i]
+        timers[timer_name(<Timer> i)] = {
+            'count': timer.count,
+            'seconds': timer.ticks / stats.ticks_per_sec,
+            'histogram': [timer.histogram[j] for j in xrange(HISTOGRAM_SIZE)],
+        }
+    return {
+        'enabled': stats.enabled,
+        'ticks_per_sec': stats.ticks_per_sec,
+        'counts': counts,
+        'timers': timers,
+    }
+
+
+def reset():
+    _reset()
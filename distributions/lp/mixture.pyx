@@ -26,6 +26,18 @@
 # USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 from libc.stdint cimport uint32_t
+from libcpp cimport bool
+from cython.operator cimport dereference as deref, preincrement as inc
+
+
+cdef extern from "distributions/mixture.hpp":
+    cppclass IdSet "distributions::MixtureIdTracker::IdSet":
+        cppclass iterator "const_iterator":
+            uint32_t & operator*()
+            iterator operator++() nogil
+            bint operator!=(iterator) nogil
+        iterator begin() nogil
+        iterator end() nogil
 
 
 cdef extern from "distributions/mixture.hpp":
@@ -35,6 +47,20 @@ cdef extern from "distributions/mixture.hpp":
         void remove_group (uint32_t packed) nogil except +
         uint32_t packed_to_global (uint32_t packed) nogil except +
         uint32_t global_to_packed (uint32_t packed) nogil except +
+        void track_changes (bool track) nogil except +
+        IdSet & added () nogil except +
+        IdSet & removed () nogil except +
+        void clear_changes () nogil except +
+
+
+cdef set id_set_to_set(IdSet & ids):
+    cdef set result = set()
+    cdef IdSet.iterator i = ids.begin()
+    cdef IdSet.iterator end = ids.end()
+    while i != end:
+        result.add(deref(i))
+        inc(i)
+    return result
 
 
 cdef class MixtureIdTracker:
@@ -58,3 +84,17 @@ cdef class MixtureIdTracker:
 
     def global_to_packed(self, int global_):
         return self.ptr.global_to_packed(global_)
+
+    def track_changes(self, bool track=True):
+        self.ptr.track_changes(track)
+
+    property added:
+        def __get__(self):
+            return id_set_to_set(self.ptr.added())
+
+    property removed:
+        def __get__(self):
+            return id_set_to_set(self.ptr.removed())
+
+    def clear_changes(self):
+        self.ptr.clear_changes()
@@ -28,7 +28,7 @@
 from libcpp.vector cimport vector
 
 from distributions.rng_cc cimport rng_t
-from distributions.lp.vector cimport VectorFloat
+from distributions.lp.vector cimport VectorFloat, AlignedFloats
 from distributions.sparse_counter cimport SparseCounter
 
 
@@ -39,6 +39,7 @@ cdef extern from "distributions/models/dd.hpp" namespace "distributions::Dirichl
     cppclass Shared:
         int dim
         float alphas[256]
+        size_t memory_usage () nogil
 
 
     cppclass Group:
@@ -52,6 +53,7 @@ cdef extern from "distributions/models/dd.hpp" namespace "distributions::Dirichl
         float score_value (Shared &, Value &, rng_t &) nogil except +
         float score_data (Shared &, rng_t &) nogil except +
         Value sample_value (Shared &, rng_t &) nogil except +
+        size_t memory_usage () nogil
 
 
     cppclass Sampler:
@@ -72,4 +74,18 @@ cdef extern from "distributions/models/dd.hpp" namespace "distributions::Dirichl
             (Shared &, size_t, Value &, rng_t &) nogil except +
         void score_value \
             (Shared &, Value &, VectorFloat &, rng_t &) nogil except +
+        void score_value \
+            (Shared &, Value &, AlignedFloats, rng_t &) nogil except +
+        void add_values \
+            (Shared &, size_t, int *, Value *, rng_t &) nogil except +
+        void remove_values \
+            (Shared &, size_t, int *, Value *, rng_t &) nogil except +
+        void score_values_strided \
+            (Shared &, size_t, Value *, float *, size_t, rng_t &) \
+            nogil except +
+        void gibbs_sweep \
+            (Shared &, size_t, int *, Value *, VectorFloat &, rng_t &) \
+            nogil except +
         float score_data (Shared &, rng_t &) nogil except +
+        void reserve (size_t) nogil except +
+        size_t memory_usage () nogil
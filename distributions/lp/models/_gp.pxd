@@ -33,9 +33,12 @@ from libcpp.vector cimport vector
 cimport numpy
 numpy.import_array()
 from distributions.rng_cc cimport rng_t
-from distributions.global_rng cimport get_rng
+from distributions.global_rng cimport get_rng, get_rng_or_global
 from distributions.lp.vector cimport (
+    AlignedFloats,
     VectorFloat,
+    aligned_row_stride,
+    ndarray_is_aligned,
     vector_float_from_ndarray,
     vector_float_to_ndarray,
 )
@@ -25,6 +25,9 @@
 # TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
 # USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+import numpy
+from distributions.lp.vector import aligned_zeros
+
 ctypedef _h.Value Value
 
 
@@ -35,6 +38,9 @@ cdef class Shared:
     def __dealloc__(self):
         del self.ptr
 
+    def memory_usage(self):
+        return self.ptr.memory_usage()
+
 
 cdef class Group:
     def __cinit__(self):
@@ -43,6 +49,9 @@ cdef class Group:
     def __dealloc__(self):
         del self.ptr
 
+    def memory_usage(self):
+        return self.ptr.memory_usage()
+
     def init(self, Shared shared):
         self.ptr.init(shared.ptr[0], get_rng()[0])
 
@@ -89,6 +98,12 @@ cdef class Mixture:
     def __dealloc__(self):
         del self.ptr
 
+    def memory_usage(self):
+        return self.ptr.memory_usage()
+
+    def reserve(self, int group_count):
+        self.ptr.reserve(group_count)
+
     def __len__(self):
         return self.ptr.groups.size()
 
@@ -130,13 +145,112 @@ cdef class Mixture:
               numpy.ndarray[numpy.float32_t, ndim=1] scores_accum):
         assert len(scores_accum) == self.ptr.groups.size(), \
             "scores_accum != len(mixture)"
-        vector_float_from_ndarray(self.scores, scores_accum)
-        self.ptr.score_value(shared.ptr[0], value, self.scores, get_rng()[0])
-        vector_float_to_ndarray(self.scores, scores_accum)
+        if ndarray_is_aligned(scores_accum):
+            self.ptr.score_value(
+                shared.ptr[0],
+                value,
+                AlignedFloats(<float *> scores_accum.data, len(scores_accum)),
+                get_rng()[0])
+        else:
+            vector_float_from_ndarray(self.scores, scores_accum)
+            self.ptr.score_value(
+                shared.ptr[0],
+                value,
+                self.scores,
+                get_rng()[0])
+            vector_float_to_ndarray(self.scores, scores_accum)
 
     def score_data(self, Shared shared):
         return self.ptr.score_data(shared.ptr[0], get_rng()[0])
 
+    def add_values(self, Shared shared, groupids, values, rng=None):
+        cdef numpy.ndarray[numpy.int32_t, ndim=1] ids = \
+            self._groupids_array(groupids)
+        cdef numpy.ndarray[numpy.float32_t, ndim=1] vals = \
+            numpy.ascontiguousarray(values, dtype=numpy.float32)
+        assert len(ids) == len(vals), "len(groupids) != len(values)"
+        cdef size_t count = len(vals)
+        cdef _h.Shared * shared_ptr = shared.ptr
+        cdef rng_t * rng_ptr = get_rng_or_global(rng)
+        with nogil:
+            self.ptr.add_values(
+                shared_ptr[0],
+                count,
+                <int *> ids.data,
+                <Value *> vals.data,
+                rng_ptr[0])
+
+    def remove_values(self, Shared shared, groupids, values, rng=None):
+        cdef numpy.ndarray[numpy.int32_t, ndim=1] ids = \
+            self._groupids_array(groupids)
+        cdef numpy.ndarray[numpy.float32_t, ndim=1] vals = \
+            numpy.ascontiguousarray(values, dtype=numpy.float32)
+        assert len(ids) == len(vals), "len(groupids) != len(values)"
+        cdef size_t count = len(vals)
+        cdef _h.Shared * shared_ptr = shared.ptr
+        cdef rng_t * rng_ptr = get_rng_or_global(rng)
+        with nogil:
+            self.ptr.remove_values(
+                shared_ptr[0],
+                count,
+                <int *> ids.data,
+                <Value *> vals.data,
+                rng_ptr[0])
+
+    def score_values(self, Shared shared, values, rng=None):
+        '''
+        Return a len(values) x len(mixture) array of scores.
+        '''
+        cdef numpy.ndarray[numpy.float32_t, ndim=1] vals = \
+            numpy.ascontiguousarray(values, dtype=numpy.float32)
+        cdef size_t count = len(vals)
+        cdef size_t group_count = self.ptr.groups.size()
+        cdef size_t row_stride = aligned_row_stride(group_count)
+        cdef numpy.ndarray[numpy.float32_t, ndim=1] scores = \
+            aligned_zeros(count * row_stride)
+        cdef _h.Shared * shared_ptr = shared.ptr
+        cdef rng_t * rng_ptr = get_rng_or_global(rng)
+        with nogil:
+            self.ptr.score_values_strided(
+                shared_ptr[0],
+                count,
+                <Value *> vals.data,
+                <float *> scores.data,
+                row_stride,
+                rng_ptr[0])
+        return scores.reshape((count, row_stride))[:, :group_count]
+
+    def gibbs_sweep(self, Shared shared, assignments, values, rng=None):
+        '''
+        Resample assignments in place from this feature alone,
+        with a uniform prior over existing groups.
+        assignments must be a contiguous int32 array.
+        '''
+        cdef numpy.ndarray[numpy.int32_t, ndim=1] ids = assignments
+        assert ids.flags['C_CONTIGUOUS'], "assignments is not contiguous"
+        self._groupids_array(ids)
+        cdef numpy.ndarray[numpy.float32_t, ndim=1] vals = \
+            numpy.ascontiguousarray(values, dtype=numpy.float32)
+        assert len(ids) == len(vals), "len(assignments) != len(values)"
+        cdef size_t count = len(vals)
+        cdef _h.Shared * shared_ptr = shared.ptr
+        cdef rng_t * rng_ptr = get_rng_or_global(rng)
+        with nogil:
+            self.ptr.gibbs_sweep(
+                shared_ptr[0],
+                count,
+                <int *> ids.data,
+                <Value *> vals.data,
+                self.scores,
+                rng_ptr[0])
+
+    def _groupids_array(self, groupids):
+        ids = numpy.ascontiguousarray(groupids, dtype=numpy.int32)
+        if len(ids):
+            assert 0 <= ids.min(), "groupid out of bounds"
+            assert ids.max() < len(self), "groupid out of bounds"
+        return ids
+
 
 def sample_group(Shared shared, int size):
     cdef Group group = Group()
@@ -37,6 +37,9 @@ cdef class Shared:
     def __dealloc__(self):
         del self.ptr
 
+    def memory_usage(self):
+        return self.ptr.memory_usage()
+
 # XXX: doesn't bother to validate its inputs
 cdef class Group:
     def __cinit__(self):
@@ -45,6 +48,9 @@ cdef class Group:
     def __dealloc__(self):
         del self.ptr
 
+    def memory_usage(self):
+        return self.ptr.memory_usage()
+
     def init(self, Shared shared):
         self.ptr.init(shared.ptr[0], get_rng()[0])
 
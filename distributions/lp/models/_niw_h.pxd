@@ -38,12 +38,15 @@ cdef extern from "distributions/models/niw.hpp" namespace "distributions::Normal
         float kappa
         MatrixXf psi
         float nu
+        void changed () nogil
+        size_t memory_usage () nogil
 
     cppclass Group:
         int count
         VectorXf sum_x
         MatrixXf sum_xxT
 
+        void invalidate_cache () nogil
         void init (Shared &, rng_t &) nogil except +
         void add_value (Shared &, Value &, rng_t &) nogil except +
         void add_repeated_value (Shared &, Value &, int &, rng_t &) nogil except +
@@ -52,6 +55,7 @@ cdef extern from "distributions/models/niw.hpp" namespace "distributions::Normal
         float score_value (Shared &, Value &, rng_t &) nogil except +
         float score_data (Shared &, rng_t &) nogil except +
         Value sample_value (Shared &, rng_t &) nogil except +
+        size_t memory_usage () nogil
 
     cppclass Sampler:
         void init (Shared &, Group &, rng_t &) nogil except +
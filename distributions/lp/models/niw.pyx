@@ -109,6 +109,7 @@ cdef class _Shared(_niw.Shared):
         assert raw['psi'] is not None
         self.ptr.psi = to_eigen_matf(raw['psi'])
         self.ptr.nu = raw['nu']
+        self.ptr.changed()
 
     def dump(self):
         return {
@@ -126,6 +127,7 @@ cdef class _Shared(_niw.Shared):
         psi = np.array(message.psi, dtype=float).reshape((D, D))
         self.ptr.psi = to_eigen_matf(psi)
         self.ptr.nu = message.nu
+        self.ptr.changed()
 
     def protobuf_dump(self, message):
         message.Clear()
@@ -149,6 +151,7 @@ cdef class _Group(_niw.Group):
         self.ptr.sum_x = to_eigen_vecf(raw['sum_x'])
         assert raw['sum_xxT'] is not None
         self.ptr.sum_xxT = to_eigen_matf(raw['sum_xxT'])
+        self.ptr.invalidate_cache()
 
     def dump(self):
         return {
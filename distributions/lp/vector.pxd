@@ -97,6 +97,11 @@ cdef extern from "distributions/vector.hpp" namespace "distributions":
         size_t size () nogil
 
 
+cdef extern from "distributions/aligned_allocator.hpp" \
+        namespace "distributions":
+    cdef size_t default_alignment
+
+
 cdef void vector_float_from_ndarray(
         VectorFloat & vector_float,
         numpy.ndarray[numpy.float32_t, ndim=1] ndarray)
@@ -105,3 +110,11 @@ cdef void vector_float_from_ndarray(
 cdef void vector_float_to_ndarray(
         VectorFloat & vector_float,
         numpy.ndarray[numpy.float32_t, ndim=1] ndarray)
+
+
+# true if ndarray can be wrapped as AlignedFloats without copying
+cdef bint ndarray_is_aligned(numpy.ndarray[numpy.float32_t, ndim=1] ndarray)
+
+
+# floats per row so that each row of a row-major matrix stays aligned
+cdef size_t aligned_row_stride(size_t row_size) nogil
@@ -26,6 +26,7 @@
 # USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 from libc.string cimport memcpy
+import numpy
 cimport numpy
 numpy.import_array()
 
@@ -45,3 +46,35 @@ cdef void vector_float_to_ndarray(
     cdef tuple shape = (size,)
     ndarray.resize(shape)
     memcpy(ndarray.data, vector_float.data(), size * sizeof(float))
+
+
+cdef bint ndarray_is_aligned(numpy.ndarray[numpy.float32_t, ndim=1] ndarray):
+    return (
+        ndarray.strides[0] == sizeof(float) and
+        (<size_t> ndarray.data) % default_alignment == 0
+    )
+
+
+cdef size_t aligned_row_stride(size_t row_size) nogil:
+    cdef size_t block = default_alignment // sizeof(float)
+    return (row_size + block - 1) // block * block
+
+
+def aligned_empty(size_t size, size_t alignment=64):
+    '''
+    Return an uninitialized float32 array of given size whose data is
+    aligned for zero-copy scoring, e.g. by Mixture.score_value.
+    '''
+    assert alignment % default_alignment == 0, alignment
+    cdef size_t padding = alignment // sizeof(float)
+    base = numpy.empty(size + padding, dtype=numpy.float32)
+    cdef numpy.ndarray[numpy.float32_t, ndim=1] typed = base
+    cdef size_t offset = (<size_t> typed.data) % alignment
+    cdef size_t start = ((alignment - offset) % alignment) // sizeof(float)
+    return base[start: start + size]
+
+
+def aligned_zeros(size_t size, size_t alignment=64):
+    result = aligned_empty(size, alignment)
+    result[:] = 0
+    return result
@@ -138,14 +138,32 @@ def iter_valid_sizes(example, max_size, min_size=2):
 
 @for_each_model()
 def test_sample_matches_score_counts(Model, EXAMPLE, sample_count):
+    check_sample_matches_score_counts(
+        Model,
+        EXAMPLE,
+        sample_count,
+        'sample_assignments')
+
+
+@for_each_model(lambda Model: hasattr(Model, 'sample_assignments_fast'))
+def test_sample_fast_matches_score_counts(Model, EXAMPLE, sample_count):
+    check_sample_matches_score_counts(
+        Model,
+        EXAMPLE,
+        sample_count,
+        'sample_assignments_fast')
+
+
+def check_sample_matches_score_counts(Model, EXAMPLE, sample_count, method):
     for size in iter_valid_sizes(EXAMPLE, max_size=10):
         model = Model()
         model.load(EXAMPLE)
+        sample_assignments = getattr(model, method)
 
         samples = []
         probs_dict = {}
         for _ in xrange(sample_count):
-            value = model.sample_assignments(size)
+            value = sample_assignments(size)
             sample = canonicalize(value)
             samples.append(sample)
             if sample not in probs_dict:
@@ -164,6 +182,23 @@ def test_sample_matches_score_counts(Model, EXAMPLE, sample_count):
         assert_greater(gof, MIN_GOODNESS_OF_FIT)
 
 
+@for_each_model(lambda Model: hasattr(Model, 'sample_assignment_array'))
+def test_assignment_array(Model, EXAMPLE, sample_count):
+    for size in iter_valid_sizes(EXAMPLE, max_size=10):
+        model = Model()
+        model.load(EXAMPLE)
+        for _ in xrange(10):
+            array = model.sample_assignment_array(size)
+            assert_equal(array.dtype, numpy.int32)
+            assert_equal(len(array), size)
+            expected = count_assignments(dict(enumerate(array)))
+            actual = count_assignments(array)
+            assert_equal(actual, expected)
+            assert_close(
+                model.score_assignments(array),
+                model.score_counts(expected))
+
+
 @for_each_model()
 def test_score_counts_is_normalized(Model, EXAMPLE, sample_count):
 
@@ -192,6 +227,24 @@ def test_score_counts_is_normalized(Model, EXAMPLE, sample_count):
         assert_less(abs(total - 1), tol, 'not normalized: {}'.format(total))
 
 
+@for_each_model(lambda Model: hasattr(Model, 'score_counts_grid'))
+def test_score_counts_grid_matches_score_counts(Model, EXAMPLE, *unused):
+    model = Model()
+    model.load(EXAMPLE)
+    for size in iter_valid_sizes(EXAMPLE, max_size=10, min_size=1):
+        models = []
+        for example in Model.EXAMPLES:
+            if example.get('dataset_size', size) >= size:
+                models.append(Model())
+                models[-1].load(example)
+        for _ in xrange(10):
+            counts = count_assignments(model.sample_assignments(size))
+            scores = Model.score_counts_grid(models, counts)
+            assert_equal(len(scores), len(models))
+            for grid_model, score in zip(models, scores):
+                assert_close(score, grid_model.score_counts(counts))
+
+
 def add_to_counts(counts, pos):
     counts = counts[:]
     counts[pos] += 1
@@ -277,6 +330,11 @@ def test_mixture_score_matches_score_add_value(Model, EXAMPLE, *unused):
         actual[:] = noise
         mixture.score_value(model, actual)
         assert_close(actual, expected)
+        if hasattr(mixture, 'score_value_unnormalized'):
+            unnormalized = numpy.zeros(len(counts), dtype=numpy.float32)
+            mixture.score_value_unnormalized(model, unnormalized)
+            shift = actual - unnormalized
+            assert_close(shift, shift.mean() + numpy.zeros(len(counts)))
         return actual
 
     for empty_group_count in [1, 10]:
@@ -325,3 +383,22 @@ def test_mixture_score_matches_score_add_value(Model, EXAMPLE, *unused):
                     counts[groupid] = back
             check_counts(mixture, counts, empty_group_count)
             check_scores(mixture, counts, empty_group_count)
+
+
+def test_mixture_id_tracker_changes():
+    id_tracker = MixtureIdTracker()
+    id_tracker.init(3)
+    id_tracker.track_changes()
+    assert_equal(id_tracker.added, set())
+    assert_equal(id_tracker.removed, set())
+
+    id_tracker.add_group()
+    id_tracker.add_group()
+    id_tracker.remove_group(id_tracker.global_to_packed(1))
+    id_tracker.remove_group(id_tracker.global_to_packed(3))
+    assert_equal(id_tracker.added, set([4]))
+    assert_equal(id_tracker.removed, set([1]))
+
+    id_tracker.clear_changes()
+    assert_equal(id_tracker.added, set())
+    assert_equal(id_tracker.removed, set())
@@ -592,3 +592,105 @@ def test_mixture_score(module, EXAMPLE):
         mixture.remove_value(shared, groupid, value)
         scores = check_score_value(value)
         check_score_data()
+
+
+def _empty_mixture(module, shared, group_count):
+    mixture = module.Mixture()
+    for _ in xrange(group_count):
+        group = module.Group()
+        group.init(shared)
+        mixture.append(group)
+    mixture.init(shared)
+    return mixture
+
+
+@for_each_model(
+    lambda module:
+    hasattr(module, 'Mixture') and hasattr(module.Mixture, 'gibbs_sweep'))
+def test_mixture_columns(module, EXAMPLE):
+    shared = module.Shared.from_dict(EXAMPLE['shared'])
+    values = EXAMPLE['values']
+    group_count = 3
+    groupids = numpy.arange(len(values), dtype=numpy.int32) % group_count
+
+    expected = _empty_mixture(module, shared, group_count)
+    for groupid, value in zip(groupids, values):
+        expected.add_value(shared, groupid, value)
+    actual = _empty_mixture(module, shared, group_count)
+    actual.add_values(shared, groupids, values)
+    assert_close(
+        actual.score_data(shared),
+        expected.score_data(shared),
+        err_msg='add_values')
+
+    scores = actual.score_values(shared, values)
+    assert scores.shape == (len(values), group_count), scores.shape
+    for value, row in zip(values, scores):
+        expected_row = numpy.zeros(group_count, dtype=numpy.float32)
+        expected.score_value(shared, value, expected_row)
+        assert_close(row, expected_row, err_msg='score_values')
+
+    assignments = groupids.copy()
+    actual.gibbs_sweep(shared, assignments, values)
+    assert assignments.min() >= 0
+    assert assignments.max() < group_count
+    resampled = _empty_mixture(module, shared, group_count)
+    resampled.add_values(shared, assignments, values)
+    assert_close(
+        actual.score_data(shared),
+        resampled.score_data(shared),
+        err_msg='gibbs_sweep')
+
+    actual.remove_values(shared, assignments, values)
+    empty = _empty_mixture(module, shared, group_count)
+    assert_close(
+        actual.score_data(shared),
+        empty.score_data(shared),
+        err_msg='remove_values')
+
+
+@for_each_model(lambda module: hasattr(module, 'Mixture'))
+def test_mixture_score_value_aligned(module, EXAMPLE):
+    from distributions.lp.vector import aligned_zeros
+    shared = module.Shared.from_dict(EXAMPLE['shared'])
+    values = EXAMPLE['values']
+    mixture = module.Mixture()
+    for value in values:
+        mixture.append(module.Group.from_values(shared, [value]))
+    mixture.init(shared)
+
+    size = len(mixture)
+    noise = numpy.random.randn(size).astype(numpy.float32)
+    for value in values:
+        expected = noise.copy()
+        mixture.score_value(shared, value, expected)
+
+        aligned = aligned_zeros(size)
+        aligned += noise
+        mixture.score_value(shared, value, aligned)
+        assert_close(aligned, expected, err_msg='aligned')
+
+        # an offset view cannot be wrapped and falls back to copying
+        unaligned = aligned_zeros(size + 1)[1:]
+        unaligned += noise
+        mixture.score_value(shared, value, unaligned)
+        assert_close(unaligned, expected, err_msg='unaligned')
+
+
+@for_each_model(lambda module: hasattr(module.Shared, 'memory_usage'))
+def test_memory_usage(module, EXAMPLE):
+    shared = module.Shared.from_dict(EXAMPLE['shared'])
+    assert shared.memory_usage() > 0
+    group = module.Group.from_values(shared, EXAMPLE['values'])
+    assert group.memory_usage() > 0
+
+    if hasattr(module, 'Mixture'):
+        mixture = _empty_mixture(module, shared, 1)
+        empty_bytes = mixture.memory_usage()
+        assert empty_bytes > 0
+        for _ in xrange(100):
+            mixture.add_group(shared)
+        assert mixture.memory_usage() > empty_bytes
+        group_bytes = mixture.memory_usage()
+        mixture.reserve(1000)
+        assert mixture.memory_usage() > group_bytes
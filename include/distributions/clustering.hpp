@@ -51,6 +51,19 @@ typedef std::unordered_map<count_t, count_t, TrivialHash<count_t>> Assignments;
 static std::vector<count_t> count_assignments(
         const Assignments & assignments);
 
+// Dense assignments map row i to group assignments[i], as produced by
+// sample_assignments(...). Counting these runs in parallel for large sizes.
+typedef std::vector<count_t> AssignmentVector;
+
+static std::vector<count_t> count_assignments(
+        const count_t * assignments,
+        size_t size);
+
+static std::vector<count_t> count_assignments(
+        const AssignmentVector & assignments) {
+    return count_assignments(assignments.data(), assignments.size());
+}
+
 
 // --------------------------------------------------------------------------
 // Pitman-Yor Model
@@ -72,12 +85,47 @@ struct PitmanYor {
     }
 
     std::vector<count_t> sample_assignments(
+            count_t size,
+            rng_t & rng) const {
+        std::vector<count_t> assignments(size);
+        sample_assignments(size, assignments.data(), rng);
+        return assignments;
+    }
+
+    // Writes size assignments into a caller-owned buffer.
+    void sample_assignments(
+            count_t size,
+            count_t * assignments,
+            rng_t & rng) const;
+
+    // Samples nonempty group sizes in order of first appearance,
+    // with the same distribution as counting sample_assignments(...).
+    std::vector<count_t> sample_counts(
+            count_t size,
+            rng_t & rng) const;
+
+    // This has the same distribution as sample_assignments(...), but runs
+    // in time O(size) independent of the number of groups, by sampling
+    // counts and then shuffling a canonical assignment vector.
+    std::vector<count_t> sample_assignments_fast(
             count_t size,
             rng_t & rng) const;
 
     float score_counts(
             const std::vector<count_t> & counts) const;
 
+    float score_assignments(
+            const count_t * assignments,
+            size_t size) const {
+        return score_counts(count_assignments(assignments, size));
+    }
+
+    // scores_out[i] = models[i].score_counts(counts)
+    static void score_counts_grid(
+            const std::vector<PitmanYor> & models,
+            const std::vector<count_t> & counts,
+            AlignedFloats scores_out);
+
     float score_add_value(
             count_t group_size,
             count_t nonempty_group_count,
@@ -152,12 +200,16 @@ struct PitmanYor {
             driver_.init(model);
             const size_t group_count = driver_.counts().size();
             shifted_scores_.resize(group_count);
+            empty_mask_.resize(group_count);
             for (size_t i = 0; i < group_count; ++i) {
                 if (driver_.counts(i)) {
                     _update_nonempty_group(model, i);
+                } else {
+                    shifted_scores_[i] = 0;
+                    empty_mask_[i] = 1;
                 }
             }
-            _update_empty_groups(model);
+            _update_empty_score(model);
         }
 
         bool add_value(
@@ -167,8 +219,9 @@ struct PitmanYor {
             const bool add_group = driver_.add_value(model, groupid, count);
 
             if (DIST_UNLIKELY(add_group)) {
-                shifted_scores_.packed_add();
-                _update_empty_groups(model);
+                shifted_scores_.packed_add(0);
+                empty_mask_.packed_add(1);
+                _update_empty_score(model);
             }
             _update_nonempty_group(model, groupid);
 
@@ -184,7 +237,8 @@ struct PitmanYor {
 
             if (DIST_UNLIKELY(remove_group)) {
                 shifted_scores_.packed_remove(groupid);
-                _update_empty_groups(model);
+                empty_mask_.packed_remove(groupid);
+                _update_empty_score(model);
             } else {
                 _update_nonempty_group(model, groupid);
             }
@@ -193,44 +247,73 @@ struct PitmanYor {
         }
 
         void score_value(const Model & model, AlignedFloats scores) const {
+            const float shift = -fast_log(sample_size() + model.alpha);
+            _score_value(shift, scores);
+        }
+
+        // Scores are off from score_value by a constant shift,
+        // which samplers like sample_from_scores_overwrite ignore.
+        void score_value_unnormalized(
+                const Model &,
+                AlignedFloats scores) const {
+            _score_value(0, scores);
+        }
+
+        float score_data(const Model & model) const {
+            return driver_.score_data(model);
+        }
+
+        void reserve(size_t group_count) {
+            driver_.reserve(group_count);
+            shifted_scores_.reserve(group_count);
+            empty_mask_.reserve(group_count);
+        }
+
+        size_t memory_usage() const {
+            return sizeof(*this)
+                 + heap_bytes(driver_)
+                 + heap_bytes(shifted_scores_)
+                 + heap_bytes(empty_mask_);
+        }
+
+      private:
+        void _score_value(float shift, AlignedFloats scores) const {
+            DIST_INSTRUMENT_COUNT(CLUSTERING_SCORE_VALUE);
             if (DIST_DEBUG_LEVEL >= 1) {
                 DIST_ASSERT_EQ(scores.size(), counts().size());
             }
 
             const size_t size = counts().size();
-            const float shift = -fast_log(sample_size() + model.alpha);
+            const float empty_score = empty_score_;
             const float * __restrict__ in = VectorFloat_data(shifted_scores_);
+            const float * __restrict__ mask = VectorFloat_data(empty_mask_);
             float * __restrict__ out = VectorFloat_data(scores);
 
             for (size_t i = 0; i < size; ++i) {
-                out[i] = in[i] + shift;
+                out[i] = in[i] + mask[i] * empty_score + shift;
             }
         }
 
-        float score_data(const Model & model) const {
-            return driver_.score_data(model);
-        }
-
-      private:
         void _update_nonempty_group(const Model & model, size_t groupid) {
             auto const group_size = counts(groupid);
             DIST_ASSERT2(group_size, "expected nonempty group");
             shifted_scores_[groupid] = fast_log(group_size - model.d);
+            empty_mask_[groupid] = 0;
         }
 
-        void _update_empty_groups(const Model & model) {
+        // all empty groups share a single score, applied in _score_value
+        void _update_empty_score(const Model & model) {
             size_t empty_group_count = empty_groupids().size();
             size_t nonempty_group_count = counts().size() - empty_group_count;
             float numer = model.alpha + model.d * nonempty_group_count;
             float denom = empty_group_count;
-            const float shifted_score = fast_log(numer / denom);
-            for (size_t i : empty_groupids()) {
-                shifted_scores_[i] = shifted_score;
-            }
+            empty_score_ = fast_log(numer / denom);
         }
 
         MixtureDriver<PitmanYor, count_t> driver_;
         VectorFloat shifted_scores_;
+        VectorFloat empty_mask_;
+        float empty_score_;
     };
 
     // The uncached version is useful for debugging
@@ -257,10 +340,32 @@ struct LowEntropy {
 
     std::vector<count_t> sample_assignments(
             count_t sample_size,
+            rng_t & rng) const {
+        std::vector<count_t> assignments(sample_size);
+        sample_assignments(sample_size, assignments.data(), rng);
+        return assignments;
+    }
+
+    // Writes sample_size assignments into a caller-owned buffer.
+    void sample_assignments(
+            count_t sample_size,
+            count_t * assignments,
             rng_t & rng) const;
 
     float score_counts(const std::vector<count_t> & counts) const;
 
+    float score_assignments(
+            const count_t * assignments,
+            size_t size) const {
+        return score_counts(count_assignments(assignments, size));
+    }
+
+    // scores_out[i] = models[i].score_counts(counts)
+    static void score_counts_grid(
+            const std::vector<LowEntropy> & models,
+            const std::vector<count_t> & counts,
+            AlignedFloats scores_out);
+
     float score_add_value(
             count_t group_size,
             count_t nonempty_group_count,
@@ -280,15 +385,7 @@ struct LowEntropy {
             return score;
         }
 
-        // see `python derivations/clustering.py fastlog`
-        const count_t very_large = 10000;
-        float bigger = 1.f + group_size;
-        if (group_size > very_large) {
-            return 1.f + fast_log(bigger);
-        } else {
-            return fast_log(bigger / group_size) * group_size
-                 + fast_log(bigger);
-        }
+        return _score_add_to_nonempty_group(group_size);
     }
 
     float score_remove_value(
@@ -310,9 +407,162 @@ struct LowEntropy {
 
     float log_partition_function(count_t sample_size) const;
 
-    typedef MixtureDriver<LowEntropy, count_t> Mixture;
+    // HACK gcc doesn't want Mixture defined outside of LowEntropy
+    class CachedMixture {
+      public:
+        typedef LowEntropy Model;
+        typedef typename MixtureDriver<LowEntropy, count_t>::IdSet IdSet;
+
+        std::vector<count_t> & counts() {
+            return driver_.counts();
+        }
+
+        const std::vector<count_t> & counts() const {
+            return driver_.counts();
+        }
+
+        count_t counts(size_t groupid) const {
+            return driver_.counts(groupid);
+        }
+
+        const IdSet & empty_groupids() const {
+            return driver_.empty_groupids();
+        }
+
+        size_t sample_size() const {
+            return driver_.sample_size();
+        }
+
+        void init(const Model & model) {
+            driver_.init(model);
+            const size_t group_count = driver_.counts().size();
+            nonempty_scores_.resize(group_count);
+            empty_mask_.resize(group_count);
+            for (size_t i = 0; i < group_count; ++i) {
+                if (driver_.counts(i)) {
+                    _update_nonempty_group(model, i);
+                } else {
+                    nonempty_scores_[i] = 0;
+                    empty_mask_[i] = 1;
+                }
+            }
+        }
+
+        bool add_value(
+                const Model & model,
+                size_t groupid,
+                count_t count = 1) {
+            const bool add_group = driver_.add_value(model, groupid, count);
+
+            if (DIST_UNLIKELY(add_group)) {
+                nonempty_scores_.packed_add(0);
+                empty_mask_.packed_add(1);
+            }
+            _update_nonempty_group(model, groupid);
+
+            return add_group;
+        }
+
+        bool remove_value(
+                const Model & model,
+                size_t groupid,
+                count_t count = 1) {
+            const bool remove_group =
+                driver_.remove_value(model, groupid, count);
+
+            if (DIST_UNLIKELY(remove_group)) {
+                nonempty_scores_.packed_remove(groupid);
+                empty_mask_.packed_remove(groupid);
+            } else {
+                _update_nonempty_group(model, groupid);
+            }
+
+            return remove_group;
+        }
+
+        void score_value(const Model & model, AlignedFloats scores) const {
+            if (DIST_DEBUG_LEVEL >= 1) {
+                DIST_ASSERT_EQ(scores.size(), counts().size());
+                DIST_ASSERT_LT(count_t(sample_size()), model.dataset_size);
+            }
+            DIST_INSTRUMENT_COUNT(CLUSTERING_SCORE_VALUE);
+
+            // the empty group score depends on sample_size,
+            // so it is computed here rather than cached
+            const count_t next_size = sample_size() + 1;
+            float empty_score = -fast_log(empty_groupids().size());
+            if (next_size < model.dataset_size) {
+                empty_score += model._approximate_postpred_correction(
+                    next_size);
+            }
+
+            const size_t size = counts().size();
+            const float * __restrict__ in =
+                VectorFloat_data(nonempty_scores_);
+            const float * __restrict__ mask = VectorFloat_data(empty_mask_);
+            float * __restrict__ out = VectorFloat_data(scores);
+
+            for (size_t i = 0; i < size; ++i) {
+                out[i] = in[i] + mask[i] * empty_score;
+            }
+        }
+
+        // LowEntropy scores need no normalizing shift;
+        // this matches the PitmanYor::CachedMixture interface.
+        void score_value_unnormalized(
+                const Model & model,
+                AlignedFloats scores) const {
+            score_value(model, scores);
+        }
+
+        float score_data(const Model & model) const {
+            return driver_.score_data(model);
+        }
+
+        void reserve(size_t group_count) {
+            driver_.reserve(group_count);
+            nonempty_scores_.reserve(group_count);
+            empty_mask_.reserve(group_count);
+        }
+
+        size_t memory_usage() const {
+            return sizeof(*this)
+                 + heap_bytes(driver_)
+                 + heap_bytes(nonempty_scores_)
+                 + heap_bytes(empty_mask_);
+        }
+
+      private:
+        void _update_nonempty_group(const Model & model, size_t groupid) {
+            auto const group_size = counts(groupid);
+            DIST_ASSERT2(group_size, "expected nonempty group");
+            nonempty_scores_[groupid] =
+                model._score_add_to_nonempty_group(group_size);
+            empty_mask_[groupid] = 0;
+        }
+
+        MixtureDriver<LowEntropy, count_t> driver_;
+        VectorFloat nonempty_scores_;
+        VectorFloat empty_mask_;
+    };
+
+    // The uncached version is useful for debugging
+    // typedef MixtureDriver<LowEntropy, count_t> Mixture;
+    typedef CachedMixture Mixture;
 
   private:
+    static float _score_add_to_nonempty_group(count_t group_size) {
+        // see `python derivations/clustering.py fastlog`
+        const count_t very_large = 10000;
+        float bigger = 1.f + group_size;
+        if (group_size > very_large) {
+            return 1.f + fast_log(bigger);
+        } else {
+            return fast_log(bigger / group_size) * group_size
+                 + fast_log(bigger);
+        }
+    }
+
     // ad hoc approximation,
     // see `python derivations/clustering.py postpred`
     // see `python derivations/clustering.py approximations`
@@ -328,6 +578,11 @@ struct LowEntropy {
     }
 
     float _approximate_dataprob_correction(count_t sample_size) const;
+
+    float _score_counts(
+            float sum_count_log_count,
+            count_t sample_size,
+            size_t group_count) const;
 };
 };  // struct Clustering<count_t>
 }   // namespace distributions
@@ -0,0 +1,141 @@
+// Copyright (c) 2014, Salesforce.com, Inc.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+// - Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// - Neither the name of Salesforce.com nor the names of its contributors
+//   may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+// COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+// OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+// TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <distributions/common.hpp>
+
+#ifdef __F16C__
+#include <immintrin.h>
+#endif
+
+// bfloat16_t and float16_t store floats in 16 bits, for caches of scores
+// whose memory traffic dominates scoring.  They convert implicitly to and
+// from float, rounding to nearest even, so arithmetic is done in float.
+//
+// bfloat16_t keeps float's 8-bit exponent and 8 bits of precision,
+// so it has float's range but only 2-3 significant decimal digits.
+// float16_t is IEEE 754 binary16, with 11 bits of precision but a range
+// of only 6e-5 to 65504, beyond which values flush to zero or infinity.
+// float16_t conversion is done in software unless F16C is enabled,
+// e.g. by -mf16c or -march=native.
+
+namespace distributions {
+
+inline uint32_t float_to_bits(float x) {
+    uint32_t bits;
+    memcpy(& bits, & x, sizeof(bits));
+    return bits;
+}
+
+inline float bits_to_float(uint32_t bits) {
+    float x;
+    memcpy(& x, & bits, sizeof(x));
+    return x;
+}
+
+struct bfloat16_t {
+    uint16_t bits;
+
+    bfloat16_t() = default;
+    bfloat16_t(float x) : bits(from_float(x)) {}  // NOLINT(*)
+    operator float() const { return to_float(bits); }
+
+    static uint16_t from_float(float x) {
+        const uint32_t bits = float_to_bits(x);
+        if (DIST_UNLIKELY((bits & 0x7fffffffu) > 0x7f800000u)) {
+            return (bits >> 16) | 0x40;  // quiet NaN
+        }
+        const uint32_t round = 0x7fffu + ((bits >> 16) & 1u);
+        return (bits + round) >> 16;
+    }
+
+    static float to_float(uint16_t bits) {
+        return bits_to_float(uint32_t(bits) << 16);
+    }
+};
+
+struct float16_t {
+    uint16_t bits;
+
+    float16_t() = default;
+    float16_t(float x) : bits(from_float(x)) {}  // NOLINT(*)
+    operator float() const { return to_float(bits); }
+
+    static uint16_t from_float(float x) {
+#ifdef __F16C__
+        return _cvtss_sh(x, 0);
+#else  // __F16C__
+        const uint32_t f32_infinity = 255u << 23;
+        const uint32_t f16_overflow = (127u + 16u) << 23;
+        const uint32_t f16_min_normal = 113u << 23;
+        uint32_t bits = float_to_bits(x);
+        const uint32_t sign = bits & 0x80000000u;
+        bits ^= sign;
+
+        uint16_t result;
+        if (DIST_UNLIKELY(bits >= f16_overflow)) {
+            result = (bits > f32_infinity) ? 0x7e00 : 0x7c00;
+        } else if (DIST_UNLIKELY(bits < f16_min_normal)) {
+            // adding a magic number rounds subnormals in float arithmetic
+            const uint32_t magic_bits = (127u - 15u + 23u - 10u + 1u) << 23;
+            const float sum = bits_to_float(bits) + bits_to_float(magic_bits);
+            result = float_to_bits(sum) - magic_bits;
+        } else {
+            const uint32_t odd = (bits >> 13) & 1u;
+            bits -= (127u - 15u) << 23;
+            bits += 0xfffu + odd;
+            result = bits >> 13;
+        }
+        return result | (sign >> 16);
+#endif  // __F16C__
+    }
+
+    static float to_float(uint16_t bits) {
+#ifdef __F16C__
+        return _cvtsh_ss(bits);
+#else  // __F16C__
+        const uint32_t exponent_mask = 0x7c00u << 13;
+        uint32_t result = (bits & 0x7fffu) << 13;
+        const uint32_t exponent = result & exponent_mask;
+        result += (127u - 15u) << 23;
+        if (DIST_UNLIKELY(exponent == exponent_mask)) {
+            result += (128u - 16u) << 23;  // infinity or NaN
+        } else if (DIST_UNLIKELY(exponent == 0)) {
+            // renormalize subnormals in float arithmetic
+            result += 1u << 23;
+            result = float_to_bits(
+                bits_to_float(result) - bits_to_float(113u << 23));
+        }
+        return bits_to_float(result | (uint32_t(bits & 0x8000u) << 16));
+#endif  // __F16C__
+    }
+};
+
+}  // namespace distributions
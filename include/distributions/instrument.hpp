@@ -0,0 +1,170 @@
+// Copyright (c) 2014, Salesforce.com, Inc.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+// - Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// - Neither the name of Salesforce.com nor the names of its contributors
+//   may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+// COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+// OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+// TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <distributions/common.hpp>
+#include <distributions/timers.hpp>
+
+// Instrumentation is compiled out unless DIST_INSTRUMENT is nonzero.
+// The snapshot API is always available, and reports enabled() == false
+// and zero counts when compiled out.
+#ifndef DIST_INSTRUMENT
+#  define DIST_INSTRUMENT 0
+#endif  // DIST_INSTRUMENT
+
+#if DIST_INSTRUMENT
+#  define DIST_INSTRUMENT_COUNT(counter) \
+    ::distributions::instrument::count( \
+        ::distributions::instrument::counter)
+#  define DIST_INSTRUMENT_TIMER_(timer, line) \
+    ::distributions::instrument::ScopedTimer PRIVATE_timer_ ## line( \
+        ::distributions::instrument::timer)
+#  define DIST_INSTRUMENT_TIMER__(timer, line) \
+    DIST_INSTRUMENT_TIMER_(timer, line)
+#  define DIST_INSTRUMENT_TIMER(timer) \
+    DIST_INSTRUMENT_TIMER__(timer, __LINE__)
+#else  // DIST_INSTRUMENT
+#  define DIST_INSTRUMENT_COUNT(counter)
+#  define DIST_INSTRUMENT_TIMER(timer)
+#endif  // DIST_INSTRUMENT
+
+namespace distributions {
+namespace instrument {
+
+#define DIST_INSTRUMENT_COUNTERS(x) \
+    x(SCORE_VALUE) \
+    x(SCORE_VALUE_GROUP) \
+    x(SCORE_VALUES) \
+    x(SCORE_DATA) \
+    x(ADD_VALUE) \
+    x(REMOVE_VALUE) \
+    x(ADD_GROUP) \
+    x(REMOVE_GROUP) \
+    x(UPDATE_GROUP) \
+    x(UPDATE_ALL) \
+    x(CLUSTERING_SCORE_VALUE) \
+    x(FAST_LGAMMA_FALLBACK) \
+    x(FAST_LGAMMA_NU_FALLBACK)
+
+#define DIST_INSTRUMENT_TIMERS(x) \
+    x(SCORE_VALUE_TIME) \
+    x(SCORE_VALUES_TIME) \
+    x(SCORE_DATA_TIME) \
+    x(ADD_VALUE_TIME) \
+    x(REMOVE_VALUE_TIME)
+
+#define DIST_INSTRUMENT_ENUM(name) name,
+enum Counter { DIST_INSTRUMENT_COUNTERS(DIST_INSTRUMENT_ENUM) COUNTER_COUNT };
+enum Timer { DIST_INSTRUMENT_TIMERS(DIST_INSTRUMENT_ENUM) TIMER_COUNT };
+#undef DIST_INSTRUMENT_ENUM
+
+enum { HISTOGRAM_SIZE = 64 };
+
+const char * counter_name(Counter counter);
+const char * timer_name(Timer timer);
+
+// Each thread owns one ThreadStats, which only it writes,
+// so updates need no read-modify-write atomics.
+struct ThreadStats {
+    std::atomic<uint64_t> counts[COUNTER_COUNT];
+    std::atomic<uint64_t> timer_counts[TIMER_COUNT];
+    std::atomic<uint64_t> timer_ticks[TIMER_COUNT];
+    // timer_histograms[t][i] counts durations in [2^(i-1), 2^i) ticks
+    std::atomic<uint64_t> timer_histograms[TIMER_COUNT][HISTOGRAM_SIZE];
+};
+
+// registered on first use and never freed, so that counts outlive threads
+ThreadStats & create_thread_stats();
+
+inline ThreadStats & thread_stats() {
+    static thread_local ThreadStats * stats = nullptr;
+    if (DIST_UNLIKELY(stats == nullptr)) {
+        stats = & create_thread_stats();
+    }
+    return * stats;
+}
+
+inline void increment(std::atomic<uint64_t> & value, uint64_t delta = 1) {
+    value.store(
+        value.load(std::memory_order_relaxed) + delta,
+        std::memory_order_relaxed);
+}
+
+inline void count(Counter counter, uint64_t delta = 1) {
+    increment(thread_stats().counts[counter], delta);
+}
+
+inline void record_time(Timer timer, uint64_t ticks) {
+    ThreadStats & stats = thread_stats();
+    increment(stats.timer_counts[timer]);
+    increment(stats.timer_ticks[timer], ticks);
+    const size_t bin = ticks ? 64 - __builtin_clzll(ticks) : 0;
+    increment(stats.timer_histograms[timer][bin < HISTOGRAM_SIZE
+        ? bin
+        : HISTOGRAM_SIZE - 1]);
+}
+
+class ScopedTimer {
+  public:
+    explicit ScopedTimer(Timer timer) :
+        timer_(timer),
+        start_(current_ticks()) {}
+
+    ~ScopedTimer() {
+        record_time(timer_, current_ticks() - start_);
+    }
+
+  private:
+    const Timer timer_;
+    const uint64_t start_;
+};
+
+struct TimerStats {
+    uint64_t count;
+    uint64_t ticks;
+    uint64_t histogram[HISTOGRAM_SIZE];
+};
+
+// Totals over all threads.  Snapshots taken while other threads are
+// running are not atomic across counters, but each count is exact.
+struct Stats {
+    bool enabled;
+    double ticks_per_sec;
+    uint64_t counts[COUNTER_COUNT];
+    TimerStats timers[TIMER_COUNT];
+};
+
+Stats snapshot();
+void reset();
+
+inline bool enabled() { return DIST_INSTRUMENT; }
+
+}  // namespace instrument
+}  // namespace distributions
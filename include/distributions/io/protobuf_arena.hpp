@@ -0,0 +1,178 @@
+// Copyright (c) 2014, Salesforce.com, Inc.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+// - Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// - Neither the name of Salesforce.com nor the names of its contributors
+//   may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+// COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+// OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+// TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <vector>
+#include <google/protobuf/arena.h>
+#include <distributions/common.hpp>
+#include <distributions/io/protobuf.hpp>
+#include <distributions/io/protobuf_stream.hpp>
+
+namespace distributions {
+namespace protobuf {
+
+// --------------------------------------------------------------------------
+// Arena Dumper
+//
+// Checkpointing a large mixture through fresh messages costs several heap
+// allocations per group for messages and their repeated fields.
+// An ArenaDumper allocates its messages from a protobuf Arena and reuses
+// them across dumps: protobuf_dump clears each message, which keeps the
+// capacity of its repeated fields, so steady-state dumps of a mixture of
+// similar size allocate nothing.  All messages are freed at once when
+// the dumper is destroyed or reset.
+//
+// Message reuse works with any protobuf version; arena allocation of
+// the messages themselves requires protobuf >= 3.
+
+template<class Model, class SharedMessage, class GroupMessage>
+class ArenaDumper {
+  public:
+    typedef typename Model::Shared Shared;
+    typedef typename Model::Group Group;
+
+    explicit ArenaDumper(size_t block_size = 1UL << 20) :
+        arena_(arena_options(block_size)),
+        shared_message_(create<SharedMessage>()),
+        group_messages_(),
+        group_count_(0) {}
+
+    void reset() {
+        group_messages_.clear();
+        group_count_ = 0;
+        arena_.Reset();
+        shared_message_ = create<SharedMessage>();
+    }
+
+    const SharedMessage & shared_message() const { return * shared_message_; }
+    size_t group_count() const { return group_count_; }
+    const GroupMessage & group_message(size_t groupid) const {
+        DIST_ASSERT1(groupid < group_count_, "bad groupid: " << groupid);
+        return * group_messages_[groupid];
+    }
+
+    void dump(const Shared & shared, const std::vector<Group> & groups) {
+        shared.protobuf_dump(* shared_message_);
+        group_count_ = groups.size();
+        while (group_messages_.size() < group_count_) {
+            group_messages_.push_back(create<GroupMessage>());
+        }
+        for (size_t i = 0; i < group_count_; ++i) {
+            groups[i].protobuf_dump(* group_messages_[i]);
+        }
+    }
+
+    void load(Shared & shared, std::vector<Group> & groups) const {
+        shared.protobuf_load(* shared_message_);
+        groups.resize(group_count_);
+        for (size_t i = 0; i < group_count_; ++i) {
+            groups[i].protobuf_load(* group_messages_[i]);
+        }
+    }
+
+    // the stream is the shared message followed by one message per group
+    void write(OutFile & file) const {
+        file.write_stream(* shared_message_);
+        for (size_t i = 0; i < group_count_; ++i) {
+            file.write_stream(* group_messages_[i]);
+        }
+    }
+
+    void read(InFile & file) {
+        DIST_ASSERT(file.try_read_stream(* shared_message_),
+            "missing shared message in " << file.filename());
+        group_count_ = 0;
+        while (true) {
+            if (group_count_ == group_messages_.size()) {
+                group_messages_.push_back(create<GroupMessage>());
+            }
+            if (not file.try_read_stream(* group_messages_[group_count_])) {
+                break;
+            }
+            ++group_count_;
+        }
+    }
+
+    size_t space_used() const {
+#if GOOGLE_PROTOBUF_VERSION >= 3000000
+        return arena_.SpaceUsed();
+#else  // GOOGLE_PROTOBUF_VERSION >= 3000000
+        return 0;
+#endif  // GOOGLE_PROTOBUF_VERSION >= 3000000
+    }
+
+  private:
+    ArenaDumper(const ArenaDumper &) = delete;
+    void operator=(const ArenaDumper &) = delete;
+
+#if GOOGLE_PROTOBUF_VERSION >= 3000000
+    typedef google::protobuf::Arena Arena;
+
+    static google::protobuf::ArenaOptions arena_options(size_t block_size) {
+        google::protobuf::ArenaOptions options;
+        options.start_block_size = block_size;
+        options.max_block_size = block_size;
+        return options;
+    }
+
+    template<class Message>
+    Message * create() {
+        return Arena::CreateMessage<Message>(& arena_);
+    }
+#else  // GOOGLE_PROTOBUF_VERSION >= 3000000
+    // without arenas, messages are owned by a simple pool
+    struct Arena {
+        explicit Arena(size_t) {}
+        ~Arena() { Reset(); }
+        void Reset() {
+            for (auto * message : messages) {
+                delete message;
+            }
+            messages.clear();
+        }
+        std::vector<google::protobuf::Message *> messages;
+    };
+
+    static size_t arena_options(size_t block_size) { return block_size; }
+
+    template<class Message>
+    Message * create() {
+        Message * message = new Message();
+        arena_.messages.push_back(message);
+        return message;
+    }
+#endif  // GOOGLE_PROTOBUF_VERSION >= 3000000
+
+    Arena arena_;
+    SharedMessage * shared_message_;
+    std::vector<GroupMessage *> group_messages_;
+    size_t group_count_;
+};
+
+}  // namespace protobuf
+}  // namespace distributions
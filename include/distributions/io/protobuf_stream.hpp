@@ -0,0 +1,263 @@
+// Copyright (c) 2014, Salesforce.com, Inc.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+// - Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// - Neither the name of Salesforce.com nor the names of its contributors
+//   may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+// COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+// OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+// TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <google/protobuf/message.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/gzip_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+#include <distributions/common.hpp>
+#include <distributions/io/protobuf.hpp>
+
+namespace distributions {
+namespace protobuf {
+
+// --------------------------------------------------------------------------
+// Protobuf Streams
+//
+// A stream is a sequence of messages, each prefixed by its size as a
+// little-endian uint32, as written by distributions.io.stream in python.
+// Files whose names end in .gz are gzip compressed.
+
+inline bool filename_is_gzipped(const std::string & filename) {
+    const std::string suffix = ".gz";
+    return filename.size() >= suffix.size() and
+        filename.compare(
+            filename.size() - suffix.size(),
+            suffix.size(),
+            suffix) == 0;
+}
+
+class InFile {
+  public:
+    explicit InFile(const std::string & filename) : filename_(filename) {
+        fid_ = open(filename.c_str(), O_RDONLY);
+        DIST_ASSERT(fid_ != -1, "failed to open " << filename);
+        file_.reset(new google::protobuf::io::FileInputStream(fid_));
+        if (filename_is_gzipped(filename)) {
+            gzip_.reset(new google::protobuf::io::GzipInputStream(
+                file_.get(),
+                google::protobuf::io::GzipInputStream::GZIP));
+            stream_ = gzip_.get();
+        } else {
+            stream_ = file_.get();
+        }
+    }
+
+    ~InFile() {
+        gzip_.reset();
+        file_.reset();
+        close(fid_);
+    }
+
+    const std::string & filename() const { return filename_; }
+
+    // returns false at end of stream; a partial size prefix is an error
+    bool try_read_stream(google::protobuf::Message & message) {
+        if (DIST_UNLIKELY(_at_end())) {
+            return false;
+        }
+        google::protobuf::io::CodedInputStream coded(stream_);
+        uint32_t size;
+        DIST_ASSERT(coded.ReadLittleEndian32(& size),
+            "truncated message size in " << filename_);
+        auto limit = coded.PushLimit(size);
+        DIST_ASSERT(message.ParseFromCodedStream(& coded),
+            "failed to parse message from " << filename_);
+        DIST_ASSERT(coded.ConsumedEntireMessage(),
+            "truncated message in " << filename_);
+        coded.PopLimit(limit);
+        return true;
+    }
+
+  private:
+    InFile(const InFile &) = delete;
+    void operator=(const InFile &) = delete;
+
+    bool _at_end() {
+        const void * data;
+        int size;
+        while (stream_->Next(& data, & size)) {
+            if (size) {
+                stream_->BackUp(size);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const std::string filename_;
+    int fid_;
+    std::unique_ptr<google::protobuf::io::FileInputStream> file_;
+    std::unique_ptr<google::protobuf::io::GzipInputStream> gzip_;
+    google::protobuf::io::ZeroCopyInputStream * stream_;
+};
+
+class OutFile {
+  public:
+    explicit OutFile(const std::string & filename) : filename_(filename) {
+        fid_ = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0664);
+        DIST_ASSERT(fid_ != -1, "failed to open " << filename);
+        file_.reset(new google::protobuf::io::FileOutputStream(fid_));
+        if (filename_is_gzipped(filename)) {
+            google::protobuf::io::GzipOutputStream::Options options;
+            options.format = google::protobuf::io::GzipOutputStream::GZIP;
+            gzip_.reset(new google::protobuf::io::GzipOutputStream(
+                file_.get(),
+                options));
+            stream_ = gzip_.get();
+        } else {
+            stream_ = file_.get();
+        }
+    }
+
+    // Destroying an unclosed OutFile closes it but ignores errors,
+    // since destructors must not throw; call close() to check them.
+    ~OutFile() {
+        if (file_) {
+            if (gzip_) {
+                gzip_->Close();
+            }
+            file_->Close();
+        }
+    }
+
+    const std::string & filename() const { return filename_; }
+
+    // flushes and closes the file, failing if any write failed
+    void close() {
+        DIST_ASSERT(file_, "already closed " << filename_);
+        bool ok = true;
+        if (gzip_) {
+            ok = gzip_->Close() and ok;
+            gzip_.reset();
+        }
+        ok = file_->Close() and ok;
+        file_.reset();
+        stream_ = nullptr;
+        DIST_ASSERT(ok, "failed to close " << filename_);
+    }
+
+    void write_stream(const google::protobuf::Message & message) {
+        DIST_ASSERT1(file_, "write to closed " << filename_);
+        google::protobuf::io::CodedOutputStream coded(stream_);
+#if GOOGLE_PROTOBUF_VERSION >= 3001000
+        const uint32_t size = message.ByteSizeLong();
+#else  // GOOGLE_PROTOBUF_VERSION >= 3001000
+        const uint32_t size = message.ByteSize();
+#endif  // GOOGLE_PROTOBUF_VERSION >= 3001000
+        coded.WriteLittleEndian32(size);
+        message.SerializeWithCachedSizes(& coded);
+        DIST_ASSERT(not coded.HadError(),
+            "failed to write message to " << filename_);
+    }
+
+  private:
+    OutFile(const OutFile &) = delete;
+    void operator=(const OutFile &) = delete;
+
+    const std::string filename_;
+    int fid_;
+    std::unique_ptr<google::protobuf::io::FileOutputStream> file_;
+    std::unique_ptr<google::protobuf::io::GzipOutputStream> gzip_;
+    google::protobuf::io::ZeroCopyOutputStream * stream_;
+};
+
+// Typed group streams reuse a single message across groups.
+// Message is the protobuf Group message of Model.
+
+template<class Model, class Message>
+class GroupReader {
+  public:
+    typedef typename Model::Group Group;
+
+    explicit GroupReader(const std::string & filename) : file_(filename) {}
+
+    // returns false at end of stream
+    bool try_read(Group & group) {
+        if (file_.try_read_stream(message_)) {
+            group.protobuf_load(message_);
+            return true;
+        } else {
+            return false;
+        }
+    }
+
+    template<class Fun>
+    size_t for_each(Fun fun) {
+        Group group;
+        size_t count = 0;
+        while (try_read(group)) {
+            fun(group);
+            ++count;
+        }
+        return count;
+    }
+
+    void read_all(std::vector<Group> & groups) {
+        for_each([&](const Group & group){ groups.push_back(group); });
+    }
+
+  private:
+    InFile file_;
+    Message message_;
+};
+
+template<class Model, class Message>
+class GroupWriter {
+  public:
+    typedef typename Model::Group Group;
+
+    explicit GroupWriter(const std::string & filename) : file_(filename) {}
+
+    void write(const Group & group) {
+        group.protobuf_dump(message_);
+        file_.write_stream(message_);
+    }
+
+    void write_all(const std::vector<Group> & groups) {
+        for (const auto & group : groups) {
+            write(group);
+        }
+    }
+
+    void close() { file_.close(); }
+
+  private:
+    OutFile file_;
+    Message message_;
+};
+
+}  // namespace protobuf
+}  // namespace distributions
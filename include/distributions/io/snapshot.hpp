@@ -0,0 +1,339 @@
+// Copyright (c) 2014, Salesforce.com, Inc.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+// - Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// - Neither the name of Salesforce.com nor the names of its contributors
+//   may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+// COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+// OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+// TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <vector>
+#include <distributions/common.hpp>
+#include <distributions/random_fwd.hpp>
+
+namespace distributions {
+
+// --------------------------------------------------------------------------
+// Snapshots
+//
+// A snapshot is a flat binary image of a Shared and a packed array of
+// Groups, laid out so that a reader can mmap the file and use the
+// structs in place, without parsing:
+//
+//   [SnapshotHeader][pad][Shared][pad][Group 0][Group 1]...
+//
+// Both the Shared and the group array start at alignment boundaries.
+// The format is only defined for models whose Shared and Group are
+// trivially copyable, and is only portable between builds that agree
+// on their layout, which the header records and the reader checks.
+// Use protobuf for portable archives; the converters below translate.
+
+struct SnapshotHeader {
+    enum { current_version = 1, alignment = 64 };
+
+    char magic[8];
+    uint32_t version;
+    uint32_t shared_size;
+    uint32_t group_size;
+    uint32_t group_align;
+    uint64_t model_tag;
+    uint64_t group_count;
+    uint64_t shared_offset;
+    uint64_t groups_offset;
+    uint64_t file_size;
+    uint64_t checksum;
+
+    static const char * expected_magic() { return "DISTSNAP"; }
+
+    static uint64_t align(uint64_t offset) {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    template<class Model>
+    static uint64_t tag() {
+        // FNV-1a hash of the demangled model name
+        const std::string name = demangle(typeid(Model).name());
+        uint64_t hash = 14695981039346656037ULL;
+        for (char c : name) {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    template<class Model>
+    void init(size_t count) {
+        typedef typename Model::Shared Shared;
+        typedef typename Model::Group Group;
+        memcpy(magic, expected_magic(), sizeof(magic));
+        version = current_version;
+        shared_size = sizeof(Shared);
+        group_size = sizeof(Group);
+        group_align = alignof(Group);
+        model_tag = tag<Model>();
+        group_count = count;
+        shared_offset = align(sizeof(SnapshotHeader));
+        groups_offset = align(shared_offset + shared_size);
+        file_size = groups_offset + group_count * group_size;
+        checksum = 0;
+    }
+
+    template<class Model>
+    void validate() const {
+        typedef typename Model::Shared Shared;
+        typedef typename Model::Group Group;
+        DIST_ASSERT(memcmp(magic, expected_magic(), sizeof(magic)) == 0,
+            "not a snapshot file");
+        DIST_ASSERT_EQ(version, current_version);
+        DIST_ASSERT(model_tag == tag<Model>(),
+            "snapshot was not written by "
+            << demangle(typeid(Model).name()));
+        DIST_ASSERT_EQ(shared_size, sizeof(Shared));
+        DIST_ASSERT_EQ(group_size, sizeof(Group));
+        DIST_ASSERT_EQ(group_align, alignof(Group));
+        DIST_ASSERT_EQ(shared_offset, align(sizeof(SnapshotHeader)));
+        DIST_ASSERT_EQ(groups_offset, align(shared_offset + shared_size));
+        DIST_ASSERT_EQ(file_size, groups_offset + group_count * group_size);
+    }
+};
+
+// FNV-1a over 64-bit words, with a bytewise tail.
+// Every update but the last must be a whole number of words.
+class SnapshotChecksum {
+  public:
+    SnapshotChecksum() : hash_(14695981039346656037ULL), done_(false) {}
+
+    void update(const void * data, size_t size) {
+        DIST_ASSERT1(not done_, "checksum update after a partial word");
+        const char * bytes = static_cast<const char *>(data);
+        const size_t word_count = size / sizeof(uint64_t);
+        for (size_t i = 0; i < word_count; ++i) {
+            uint64_t word;
+            memcpy(& word, bytes + i * sizeof(uint64_t), sizeof(uint64_t));
+            hash_ = (hash_ ^ word) * 1099511628211ULL;
+        }
+        for (size_t i = word_count * sizeof(uint64_t); i < size; ++i) {
+            hash_ = (hash_ ^ static_cast<unsigned char>(bytes[i]))
+                  * 1099511628211ULL;
+            done_ = true;
+        }
+    }
+
+    uint64_t digest() const { return hash_; }
+
+  private:
+    uint64_t hash_;
+    bool done_;
+};
+
+template<class Model>
+void snapshot_dump(
+        const std::string & filename,
+        const typename Model::Shared & shared,
+        const typename Model::Group * groups,
+        size_t group_count) {
+    typedef typename Model::Shared Shared;
+    typedef typename Model::Group Group;
+    static_assert(
+        std::is_trivially_copyable<Shared>::value and
+        std::is_trivially_copyable<Group>::value,
+        "snapshots require trivially copyable Shared and Group");
+
+    SnapshotHeader header;
+    memset(& header, 0, sizeof(header));
+    header.init<Model>(group_count);
+
+    const std::vector<char> padding(SnapshotHeader::alignment, 0);
+    std::vector<char> shared_block(
+        header.groups_offset - header.shared_offset, 0);
+    memcpy(shared_block.data(), & shared, sizeof(Shared));
+    const size_t groups_size = group_count * sizeof(Group);
+
+    SnapshotChecksum checksum;
+    checksum.update(shared_block.data(), shared_block.size());
+    checksum.update(groups, groups_size);
+    header.checksum = checksum.digest();
+
+    std::ofstream file(filename, std::ios::out | std::ios::binary);
+    DIST_ASSERT(file, "failed to open " << filename);
+    file.write(reinterpret_cast<const char *>(& header), sizeof(header));
+    file.write(padding.data(), header.shared_offset - sizeof(header));
+    file.write(shared_block.data(), shared_block.size());
+    file.write(reinterpret_cast<const char *>(groups), groups_size);
+    file.close();
+    DIST_ASSERT(file, "failed to write " << filename);
+}
+
+template<class Model>
+inline void snapshot_dump(
+        const std::string & filename,
+        const typename Model::Shared & shared,
+        const std::vector<typename Model::Group> & groups) {
+    snapshot_dump<Model>(filename, shared, groups.data(), groups.size());
+}
+
+// A read-only mmap of a whole file, unmapped on destruction, so that a
+// Snapshot whose validation fails does not leak its mapping.
+class SnapshotMapping {
+  public:
+    explicit SnapshotMapping(const std::string & filename) :
+        data_(nullptr),
+        size_(0) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        DIST_ASSERT(fd != -1, "failed to open " << filename);
+        struct stat info;
+        const off_t min_size = sizeof(SnapshotHeader);
+        if (fstat(fd, & info) == 0 and info.st_size >= min_size) {
+            void * data =
+                mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                data_ = static_cast<const char *>(data);
+                size_ = info.st_size;
+            }
+        }
+        close(fd);
+        DIST_ASSERT(data_, "failed to map " << filename);
+    }
+
+    ~SnapshotMapping() {
+        if (data_) {
+            munmap(const_cast<char *>(data_), size_);
+        }
+    }
+
+    const char * data() const { return data_; }
+    size_t size() const { return size_; }
+
+  private:
+    SnapshotMapping(const SnapshotMapping &) = delete;
+    void operator=(const SnapshotMapping &) = delete;
+
+    const char * data_;
+    size_t size_;
+};
+
+// A read-only mapping of a snapshot file.
+// shared() and groups() point into the mapping and are valid for the
+// lifetime of the Snapshot; restore() copies them into a mixture.
+template<class Model>
+class Snapshot {
+  public:
+    typedef typename Model::Shared Shared;
+    typedef typename Model::Group Group;
+
+    explicit Snapshot(const std::string & filename, bool verify = true) :
+        mapping_(filename) {
+        static_assert(
+            std::is_trivially_copyable<Shared>::value and
+            std::is_trivially_copyable<Group>::value,
+            "snapshots require trivially copyable Shared and Group");
+
+        header().template validate<Model>();
+        DIST_ASSERT_EQ(header().file_size, mapping_.size());
+        if (verify) {
+            SnapshotChecksum checksum;
+            checksum.update(
+                mapping_.data() + header().shared_offset,
+                mapping_.size() - header().shared_offset);
+            DIST_ASSERT(checksum.digest() == header().checksum,
+                "checksum mismatch in " << filename);
+        }
+    }
+
+    const SnapshotHeader & header() const {
+        return * reinterpret_cast<const SnapshotHeader *>(mapping_.data());
+    }
+
+    const Shared & shared() const {
+        return * reinterpret_cast<const Shared *>(
+            mapping_.data() + header().shared_offset);
+    }
+
+    size_t group_count() const { return header().group_count; }
+
+    const Group * groups() const {
+        return reinterpret_cast<const Group *>(
+            mapping_.data() + header().groups_offset);
+    }
+
+    const Group & groups(size_t groupid) const {
+        DIST_ASSERT1(groupid < group_count(), "bad groupid: " << groupid);
+        return groups()[groupid];
+    }
+
+    // Mixture is any MixtureSlave over Model
+    template<class Mixture>
+    void restore(Shared & shared_out, Mixture & mixture, rng_t & rng) const {
+        shared_out = shared();
+        mixture.groups().assign(groups(), groups() + group_count());
+        mixture.init(shared_out, rng);
+    }
+
+  private:
+    Snapshot(const Snapshot &) = delete;
+    void operator=(const Snapshot &) = delete;
+
+    SnapshotMapping mapping_;
+};
+
+// Converters to and from protobuf, where GroupMessages is a
+// google::protobuf::RepeatedPtrField<Model::Protobuf::Group>
+
+template<class Model, class SharedMessage, class GroupMessages>
+void snapshot_dump_protobuf(
+        const std::string & filename,
+        const SharedMessage & shared_message,
+        const GroupMessages & group_messages) {
+    typename Model::Shared shared;
+    shared.protobuf_load(shared_message);
+    std::vector<typename Model::Group> groups(group_messages.size());
+    for (size_t i = 0; i < groups.size(); ++i) {
+        groups[i].protobuf_load(group_messages.Get(i));
+    }
+    snapshot_dump<Model>(filename, shared, groups);
+}
+
+template<class Model, class SharedMessage, class GroupMessages>
+void snapshot_load_protobuf(
+        const std::string & filename,
+        SharedMessage & shared_message,
+        GroupMessages & group_messages) {
+    Snapshot<Model> snapshot(filename);
+    snapshot.shared().protobuf_dump(shared_message);
+    group_messages.Clear();
+    group_messages.Reserve(snapshot.group_count());
+    for (size_t i = 0; i < snapshot.group_count(); ++i) {
+        snapshot.groups(i).protobuf_dump(* group_messages.Add());
+    }
+}
+
+}  // namespace distributions
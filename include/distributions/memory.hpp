@@ -0,0 +1,131 @@
+// Copyright (c) 2014, Salesforce.com, Inc.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+// - Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// - Neither the name of Salesforce.com nor the names of its contributors
+//   may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+// COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+// OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+// TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// memory_usage() methods report bytes owned by an object, i.e. its own
+// size plus the heap memory it owns. heap_bytes(x) reports only the heap
+// part. Hash containers are estimated from libstdc++'s layout of one node
+// per entry plus one pointer per bucket; malloc overhead is ignored.
+// Elements of trivial type are assumed to own no heap memory.
+
+namespace distributions {
+
+template<class T>
+inline auto heap_bytes(const T & t) -> decltype(t.memory_usage()) {
+    return t.memory_usage() - sizeof(T);
+}
+
+template<class T>
+inline typename std::enable_if<std::is_arithmetic<T>::value, size_t>::type
+heap_bytes(const T &) {
+    return 0;
+}
+
+// Types that cannot have a memory_usage() method, such as those of other
+// libraries, can instead specialize HeapBytes<T> with a static get(t);
+// see the Eigen specializations in models/niw.hpp.
+template<class T, class Enable = void>
+struct HeapBytes {};
+
+template<class T>
+inline auto heap_bytes(const T & t) -> decltype(HeapBytes<T>::get(t)) {
+    return HeapBytes<T>::get(t);
+}
+
+template<class T, class Alloc>
+inline size_t heap_bytes(const std::vector<T, Alloc> & vector);
+
+template<class Key, class Value, class Hash, class Pred, class Alloc>
+inline size_t heap_bytes(
+        const std::unordered_map<Key, Value, Hash, Pred, Alloc> & map);
+
+template<class Key, class Hash, class Pred, class Alloc>
+inline size_t heap_bytes(
+        const std::unordered_set<Key, Hash, Pred, Alloc> & set);
+
+namespace detail {
+
+template<class Range>
+inline size_t element_heap_bytes(const Range &, std::true_type) {
+    return 0;
+}
+
+template<class Range>
+inline size_t element_heap_bytes(const Range & range, std::false_type) {
+    size_t bytes = 0;
+    for (const auto & element : range) {
+        bytes += heap_bytes(element);
+    }
+    return bytes;
+}
+
+template<class Value>
+inline size_t hash_node_bytes() {
+    const size_t word = sizeof(void *);
+    return (word + sizeof(Value) + word - 1) / word * word;
+}
+
+}  // namespace detail
+
+template<class T, class Alloc>
+inline size_t heap_bytes(const std::vector<T, Alloc> & vector) {
+    return vector.capacity() * sizeof(T) + detail::element_heap_bytes(
+        vector,
+        std::is_trivial<T>());
+}
+
+template<class Key, class Value, class Hash, class Pred, class Alloc>
+inline size_t heap_bytes(
+        const std::unordered_map<Key, Value, Hash, Pred, Alloc> & map) {
+    typedef std::pair<const Key, Value> Pair;
+    size_t bytes = map.bucket_count() * sizeof(void *)
+                 + map.size() * detail::hash_node_bytes<Pair>();
+    if (not (std::is_trivial<Key>::value and
+             std::is_trivial<Value>::value)) {
+        for (const auto & pair : map) {
+            bytes += heap_bytes(pair.first) + heap_bytes(pair.second);
+        }
+    }
+    return bytes;
+}
+
+template<class Key, class Hash, class Pred, class Alloc>
+inline size_t heap_bytes(
+        const std::unordered_set<Key, Hash, Pred, Alloc> & set) {
+    return set.bucket_count() * sizeof(void *)
+         + set.size() * detail::hash_node_bytes<Key>()
+         + detail::element_heap_bytes(set, std::is_trivial<Key>());
+}
+
+}  // namespace distributions
@@ -41,6 +41,8 @@ struct SharedMixin {
     void add_value(const Value &, rng_t &) {}
     void remove_value(const Value &, rng_t &) {}
     void realize(rng_t &) {}
+
+    size_t memory_usage() const { return sizeof(typename Model::Shared); }
 };
 
 template<class Model_>
@@ -50,6 +52,8 @@ struct GroupMixin {
     typedef typename Model::Shared Shared;
 
     void validate(const Shared &) const {}
+
+    size_t memory_usage() const { return sizeof(typename Model::Group); }
 };
 
 }   // namespace distributions
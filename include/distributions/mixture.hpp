@@ -27,14 +27,18 @@
 
 #pragma once
 
+#include <algorithm>
 #include <vector>
 #include <unordered_set>
 #include <unordered_map>
 #include <type_traits>
 #include <distributions/common.hpp>
+#include <distributions/instrument.hpp>
+#include <distributions/memory.hpp>
 #include <distributions/vector.hpp>
 #include <distributions/trivial_hash.hpp>
 #include <distributions/random_fwd.hpp>
+#include <distributions/random.hpp>
 
 namespace distributions {
 
@@ -123,6 +127,7 @@ struct MixtureDriver {
 
     void score_value(const Model & model, AlignedFloats scores) const {
         DIST_THIS_SLOW_FALLBACK_SHOULD_BE_OVERRIDDEN
+        DIST_INSTRUMENT_COUNT(CLUSTERING_SCORE_VALUE);
 
         if (DIST_DEBUG_LEVEL >= 1) {
             DIST_ASSERT_EQ(scores.size(), counts_.size());
@@ -131,7 +136,7 @@ struct MixtureDriver {
         const count_t group_count = counts_.size();
         const count_t empty_group_count = empty_groupids_.size();
         const count_t nonempty_group_count = group_count - empty_group_count;
-        for (size_t i = 0; i < group_count; ++i) {
+        for (count_t i = 0; i < group_count; ++i) {
             scores[i] = model.score_add_value(
                 counts_[i],
                 nonempty_group_count,
@@ -144,6 +149,14 @@ struct MixtureDriver {
         return model.score_counts(counts_);
     }
 
+    void reserve(size_t group_count) { counts_.reserve(group_count); }
+
+    size_t memory_usage() const {
+        return sizeof(*this)
+             + heap_bytes(counts_)
+             + heap_bytes(empty_groupids_);
+    }
+
   private:
     std::vector<count_t> counts_;
     IdSet empty_groupids_;
@@ -220,6 +233,10 @@ struct MixtureSlaveGroups {
         }
     }
 
+    void reserve(size_t group_count) { groups_.reserve(group_count); }
+
+    size_t memory_usage() const { return sizeof(*this) + heap_bytes(groups_); }
+
   private:
     Packed_<Group> groups_;
 };
@@ -247,6 +264,8 @@ struct MixtureSlaveDataScorerMixin {
     }
 
     void validate(const Shared &, const std::vector<Group> &) const {}
+
+    size_t memory_usage() const { return sizeof(Derived); }
 };
 
 template<class Model>
@@ -259,7 +278,7 @@ struct SmallMixtureSlaveDataScorer :  // NOLINT(*)
             const Shared & shared,
             const std::vector<Group> & groups,
             rng_t & rng) const {
-        float score = 0;
+        double score = 0;
         for (const Group & group : groups) {
             score += group.score_data(shared, rng);
         }
@@ -275,6 +294,7 @@ struct MixtureSlaveValueScorerMixin {
     typedef typename Model::Group Group;
 
     void resize(const Shared &, size_t) {}
+    void reserve(size_t) {}
     void add_group(const Shared &, rng_t &) {}
     void remove_group(const Shared &, size_t) {}
     void update_group(const Shared &, size_t, const Group &, rng_t &) {}
@@ -335,6 +355,31 @@ struct SmallMixtureSlaveValueScorer : MixtureSlaveValueScorerMixin<Model> {
             scores_accum[i] += groups[i].score_value(shared, value, rng);
         }
     }
+
+    size_t memory_usage() const { return sizeof(*this); }
+
+    // scores_accum is a row-major values x groups matrix
+    void score_values(
+            const Shared & shared,
+            const std::vector<Group> & groups,
+            const std::vector<Value> & values,
+            AlignedFloats scores_accum,
+            rng_t & rng) const {
+        DIST_THIS_SLOW_FALLBACK_SHOULD_BE_OVERRIDDEN
+
+        const size_t group_count = groups.size();
+        const size_t value_count = values.size();
+        if (DIST_DEBUG_LEVEL >= 2) {
+            DIST_ASSERT_EQ(scores_accum.size(), value_count * group_count);
+        }
+
+        for (size_t v = 0; v < value_count; ++v) {
+            float * scores = scores_accum.data() + v * group_count;
+            for (size_t i = 0; i < group_count; ++i) {
+                scores[i] += groups[i].score_value(shared, values[v], rng);
+            }
+        }
+    }
 };
 
 template<
@@ -356,6 +401,9 @@ struct MixtureSlave {
             rng_t & rng) {
         value_scorer_.resize(shared, groups().size());
         value_scorer_.update_all(shared, groups(), rng);
+        if (track_dirty_) {
+            clear_dirty();
+        }
     }
 
     void add_group(
@@ -365,6 +413,10 @@ struct MixtureSlave {
         groups_.add_group(shared, rng);
         value_scorer_.add_group(shared, rng);
         value_scorer_.update_group(shared, groupid, groups(groupid), rng);
+        DIST_INSTRUMENT_COUNT(ADD_GROUP);
+        if (track_dirty_) {
+            dirty_.packed_add(1);
+        }
     }
 
     void remove_group(
@@ -372,6 +424,10 @@ struct MixtureSlave {
             size_t groupid) {
         groups_.remove_group(shared, groupid);
         value_scorer_.remove_group(shared, groupid);
+        DIST_INSTRUMENT_COUNT(REMOVE_GROUP);
+        if (track_dirty_) {
+            dirty_.packed_remove(groupid);
+        }
     }
 
     void add_value(
@@ -379,8 +435,13 @@ struct MixtureSlave {
             size_t groupid,
             const Value & value,
             rng_t & rng) {
+        DIST_INSTRUMENT_COUNT(ADD_VALUE);
+        DIST_INSTRUMENT_TIMER(ADD_VALUE_TIME);
         groups_.add_value(shared, groupid, value, rng);
         value_scorer_.add_value(shared, groupid, groups(groupid), value, rng);
+        if (track_dirty_) {
+            dirty_[groupid] = 1;
+        }
     }
 
     void remove_value(
@@ -388,6 +449,8 @@ struct MixtureSlave {
             size_t groupid,
             const Value & value,
             rng_t & rng) {
+        DIST_INSTRUMENT_COUNT(REMOVE_VALUE);
+        DIST_INSTRUMENT_TIMER(REMOVE_VALUE_TIME);
         groups_.remove_value(shared, groupid, value, rng);
         value_scorer_.remove_value(
             shared,
@@ -395,6 +458,39 @@ struct MixtureSlave {
             groups(groupid),
             value,
             rng);
+        if (track_dirty_) {
+            dirty_[groupid] = 1;
+        }
+    }
+
+    // Dirty tracking marks groups that changed since the last
+    // clear_dirty(), for incremental checkpoints; see MixtureDelta.
+    // Callers that modify groups() directly must mark_dirty themselves.
+    void track_dirty(bool track) {
+        track_dirty_ = track;
+        clear_dirty();
+    }
+
+    bool is_tracking_dirty() const { return track_dirty_; }
+
+    bool dirty(size_t groupid) const {
+        DIST_ASSERT1(track_dirty_, "dirty tracking is disabled");
+        DIST_ASSERT1(groupid < dirty_.size(), "bad groupid: " << groupid);
+        return dirty_[groupid];
+    }
+
+    void mark_dirty(size_t groupid) {
+        if (track_dirty_) {
+            DIST_ASSERT1(groupid < dirty_.size(), "bad groupid: " << groupid);
+            dirty_[groupid] = 1;
+        }
+    }
+
+    void clear_dirty() {
+        dirty_.clear();
+        if (track_dirty_) {
+            dirty_.resize(groups().size(), 0);
+        }
     }
 
     float score_value_group(
@@ -405,6 +501,7 @@ struct MixtureSlave {
         if (DIST_DEBUG_LEVEL >= 2) {
             DIST_ASSERT_LT(groupid, groups().size());
         }
+        DIST_INSTRUMENT_COUNT(SCORE_VALUE_GROUP);
         return value_scorer_.score_value_group(
             shared,
             groups(),
@@ -421,12 +518,106 @@ struct MixtureSlave {
         if (DIST_DEBUG_LEVEL >= 2) {
             DIST_ASSERT_EQ(scores_accum.size(), groups().size());
         }
+        DIST_INSTRUMENT_COUNT(SCORE_VALUE);
+        DIST_INSTRUMENT_TIMER(SCORE_VALUE_TIME);
         value_scorer_.score_value(shared, groups(), value, scores_accum, rng);
     }
 
+    // scores_accum is a row-major values x groups matrix
+    void score_values(
+            const Shared & shared,
+            const std::vector<Value> & values,
+            AlignedFloats scores_accum,
+            rng_t & rng) const {
+        if (DIST_DEBUG_LEVEL >= 2) {
+            DIST_ASSERT_EQ(
+                scores_accum.size(),
+                values.size() * groups().size());
+        }
+        DIST_INSTRUMENT_COUNT(SCORE_VALUES);
+        DIST_INSTRUMENT_TIMER(SCORE_VALUES_TIME);
+        value_scorer_.score_values(
+            shared,
+            groups(),
+            values,
+            scores_accum,
+            rng);
+    }
+
+    // Column entry points operate on raw arrays, as held by bindings.
+    // Element types need only convert to size_t and Value respectively.
+
+    template<class Id, class V>
+    void add_values(
+            const Shared & shared,
+            size_t count,
+            const Id * groupids,
+            const V * values,
+            rng_t & rng) {
+        for (size_t i = 0; i < count; ++i) {
+            add_value(shared, groupids[i], Value(values[i]), rng);
+        }
+    }
+
+    template<class Id, class V>
+    void remove_values(
+            const Shared & shared,
+            size_t count,
+            const Id * groupids,
+            const V * values,
+            rng_t & rng) {
+        for (size_t i = 0; i < count; ++i) {
+            remove_value(shared, groupids[i], Value(values[i]), rng);
+        }
+    }
+
+    // scores_accum is a row-major count x groups matrix whose rows start
+    // row_stride floats apart, so that each row is aligned
+    template<class V>
+    void score_values_strided(
+            const Shared & shared,
+            size_t count,
+            const V * values,
+            float * scores_accum,
+            size_t row_stride,
+            rng_t & rng) const {
+        const size_t group_count = groups().size();
+        DIST_ASSERT_LE(group_count, row_stride);
+        for (size_t i = 0; i < count; ++i) {
+            AlignedFloats scores(scores_accum + i * row_stride, group_count);
+            score_value(shared, Value(values[i]), scores, rng);
+        }
+    }
+
+    // Resamples each assignment in turn from this feature alone, with a
+    // uniform prior over existing groups. Callers combining features or
+    // a clustering prior should instead sum score_values per row.
+    template<class Id, class V>
+    void gibbs_sweep(
+            const Shared & shared,
+            size_t count,
+            Id * assignments,
+            const V * values,
+            VectorFloat & scores,
+            rng_t & rng) {
+        const size_t group_count = groups().size();
+        for (size_t i = 0; i < count; ++i) {
+            const Value value(values[i]);
+            remove_value(shared, assignments[i], value, rng);
+            scores.resize(group_count);
+            vector_zero(group_count, scores.data());
+            score_value(shared, value, scores, rng);
+            const size_t groupid = sample_from_scores_overwrite(rng, scores);
+            add_value(shared, groupid, value, rng);
+            assignments[i] = groupid;
+        }
+    }
+
     float score_data(
             const Shared & shared,
             rng_t & rng) const {
+        DIST_INSTRUMENT_COUNT(SCORE_DATA);
+        DIST_INSTRUMENT_TIMER(SCORE_DATA_TIME);
         return data_scorer_.score_data(shared, groups(), rng);
     }
 
@@ -443,10 +634,148 @@ struct MixtureSlave {
         data_scorer_.validate(shared, groups());
     }
 
+    // Reserves capacity for group_count groups, so that add_group
+    // does not reallocate until the mixture outgrows it.
+    // Call this after init(), which sizes per-value caches.  Caches
+    // created later are not reserved: DPD value caches for values first
+    // added after init(), and GP/BNB value table rows, still reallocate
+    // as groups are added.
+    void reserve(size_t group_count) {
+        groups_.reserve(group_count);
+        value_scorer_.reserve(group_count);
+        if (track_dirty_) {
+            dirty_.reserve(group_count);
+        }
+    }
+
+    // bytes owned by this mixture, including its groups and score caches
+    size_t memory_usage() const {
+        return sizeof(*this)
+             + heap_bytes(groups_)
+             + heap_bytes(value_scorer_)
+             + heap_bytes(data_scorer_)
+             + heap_bytes(dirty_);
+    }
+
   private:
     MixtureSlaveGroups<Shared> groups_;
     ValueScorer value_scorer_;
     DataScorer data_scorer_;
+    Packed_<uint8_t> dirty_;
+    bool track_dirty_ = false;
+};
+
+
+// --------------------------------------------------------------------------
+// Mixture Value Table
+//
+// This caches scores of small nonnegative integer values, one row per value
+// and one column per group, so that scoring a cached value against all
+// groups is a single contiguous vector_add.  Rows are created by add_row()
+// when a value is first added and are kept current by the mutating methods,
+// each of which takes a score_value_group(groupid, value) callback, so
+// row() is a pure read and concurrent const scoring is safe.  Since every
+// group update rescores one column of every row, rows are limited to values
+// below max_rows, and to a table that fits in max_bytes.
+
+class MixtureValueTable {
+  public:
+    enum { max_rows = 64, max_bytes = 1 << 22 };
+
+    size_t group_count() const { return group_count_; }
+    size_t row_count() const { return rows_.size(); }
+
+    void resize(size_t group_count) {
+        rows_.clear();
+        group_count_ = group_count;
+    }
+
+    template<class ScoreGroup>
+    void add_group(const ScoreGroup & score_group) {
+        const size_t groupid = group_count_++;
+        const size_t row_count = _max_row_count();
+        if (rows_.size() > row_count) {
+            rows_.resize(row_count);
+        }
+        for (size_t value = 0; value < rows_.size(); ++value) {
+            rows_[value].packed_add(score_group(groupid, value));
+        }
+    }
+
+    void remove_group(size_t groupid) {
+        DIST_ASSERT1(groupid < group_count_, "bad groupid: " << groupid);
+        --group_count_;
+        for (auto & row : rows_) {
+            row.packed_remove(groupid);
+        }
+    }
+
+    template<class ScoreGroup>
+    void update_group(size_t groupid, const ScoreGroup & score_group) {
+        for (size_t value = 0; value < rows_.size(); ++value) {
+            rows_[value][groupid] = score_group(groupid, value);
+        }
+    }
+
+    // creates rows up to value, if they fit
+    template<class ScoreGroup>
+    void add_row(uint32_t value, const ScoreGroup & score_group) {
+        if (DIST_UNLIKELY(value >= rows_.size())) {
+            if (value >= _max_row_count()) {
+                return;
+            }
+            size_t begin = rows_.size();
+            rows_.resize(value + 1);
+            for (; begin <= value; ++begin) {
+                rows_[begin].resize(group_count_);
+                _fill(begin, score_group);
+            }
+        }
+    }
+
+    // returns the row for value, or nullptr if it has not been added
+    const float * row(uint32_t value) const {
+        if (DIST_LIKELY(value < rows_.size())) {
+            return VectorFloat_data(rows_[value]);
+        } else {
+            return nullptr;
+        }
+    }
+
+    void validate(size_t group_count) const {
+        DIST_ASSERT_EQ(group_count_, group_count);
+        DIST_ASSERT_LE(rows_.size(), _max_row_count());
+        for (const auto & row : rows_) {
+            DIST_ASSERT_EQ(row.size(), group_count);
+        }
+    }
+
+    void reserve(size_t group_count) {
+        for (auto & row : rows_) {
+            row.reserve(group_count);
+        }
+    }
+
+    size_t memory_usage() const {
+        return sizeof(*this) + heap_bytes(rows_);
+    }
+
+  private:
+    size_t _max_row_count() const {
+        const size_t row_bytes = sizeof(float) * (group_count_ + 1);
+        return std::min(size_t(max_rows), max_bytes / row_bytes);
+    }
+
+    template<class ScoreGroup>
+    void _fill(size_t value, const ScoreGroup & score_group) {
+        float * __restrict__ scores = VectorFloat_data(rows_[value]);
+        for (size_t i = 0; i < group_count_; ++i) {
+            scores[i] = score_group(i, value);
+        }
+    }
+
+    std::vector<VectorFloat> rows_;
+    size_t group_count_ = 0;
 };
 
 
@@ -459,6 +788,7 @@ struct MixtureSlave {
 
 struct MixtureIdTracker {
     typedef uint32_t Id;
+    typedef std::unordered_set<Id, TrivialHash<Id>> IdSet;
 
     void init(size_t group_count = 0) {
         packed_to_global_.clear();
@@ -467,6 +797,7 @@ struct MixtureIdTracker {
         for (size_t i = 0; i < group_count; ++i) {
             add_group();
         }
+        clear_changes();
     }
 
     void add_group() {
@@ -474,6 +805,9 @@ struct MixtureIdTracker {
         const Id global = global_size_++;
         packed_to_global_.packed_add(global);
         global_to_packed_.insert(std::make_pair(global, packed));
+        if (track_changes_) {
+            added_.insert(global);
+        }
     }
 
     void remove_group(Id packed) {
@@ -481,6 +815,13 @@ struct MixtureIdTracker {
         const Id global = packed_to_global_[packed];
         DIST_ASSERT1(global < global_size(), "bad global id: " << global);
         global_to_packed_.erase(global);
+        if (track_changes_) {
+            // groups both added and removed since the last checkpoint
+            // need not appear in the delta
+            if (not added_.erase(global)) {
+                removed_.insert(global);
+            }
+        }
         packed_to_global_.packed_remove(packed);
         if (packed != packed_size()) {
             const Id global = packed_to_global_[packed];
@@ -514,10 +855,111 @@ struct MixtureIdTracker {
     size_t packed_size() const { return packed_to_global_.size(); }
     size_t global_size() const { return global_size_; }
 
+    // Change tracking records global ids added and removed
+    // since the last clear_changes(); see MixtureDelta.
+    void track_changes(bool track) {
+        track_changes_ = track;
+        clear_changes();
+    }
+
+    bool is_tracking_changes() const { return track_changes_; }
+    const IdSet & added() const { return added_; }
+    const IdSet & removed() const { return removed_; }
+
+    void clear_changes() {
+        added_.clear();
+        removed_.clear();
+    }
+
+    void reserve(size_t group_count) {
+        packed_to_global_.reserve(group_count);
+        global_to_packed_.reserve(group_count);
+    }
+
+    size_t memory_usage() const {
+        return sizeof(*this)
+             + heap_bytes(packed_to_global_)
+             + heap_bytes(global_to_packed_)
+             + heap_bytes(added_)
+             + heap_bytes(removed_);
+    }
+
   private:
     Packed_<Id> packed_to_global_;
     std::unordered_map<Id, Id, TrivialHash<Id>> global_to_packed_;
     size_t global_size_;
+    IdSet added_;
+    IdSet removed_;
+    bool track_changes_ = false;
+};
+
+
+// --------------------------------------------------------------------------
+// Mixture Delta
+//
+// A delta records the groups of a mixture that changed between two
+// checkpoints, keyed by global id, so that checkpoint I/O scales with
+// churn rather than model size.  Collecting a delta requires dirty
+// tracking in the MixtureSlave and change tracking in its
+// MixtureIdTracker, and resets both, starting the next delta.
+
+template<class Group>
+struct MixtureDelta {
+    typedef MixtureIdTracker::Id Id;
+
+    std::vector<std::pair<Id, Group>> changed;
+    std::vector<std::pair<Id, Group>> added;
+    std::vector<Id> removed;
+
+    bool empty() const {
+        return changed.empty() and added.empty() and removed.empty();
+    }
+
+    template<class Mixture>
+    void collect(Mixture & mixture, MixtureIdTracker & id_tracker) {
+        DIST_ASSERT(mixture.is_tracking_dirty(), "dirty tracking is disabled");
+        DIST_ASSERT(id_tracker.is_tracking_changes(),
+            "change tracking is disabled");
+        const size_t group_count = mixture.groups().size();
+        DIST_ASSERT_EQ(group_count, id_tracker.packed_size());
+
+        changed.clear();
+        added.clear();
+        removed.clear();
+        const auto & added_ids = id_tracker.added();
+        for (size_t packed = 0; packed < group_count; ++packed) {
+            const Id global = id_tracker.packed_to_global(packed);
+            if (added_ids.find(global) != added_ids.end()) {
+                added.emplace_back(global, mixture.groups(packed));
+            } else if (mixture.dirty(packed)) {
+                changed.emplace_back(global, mixture.groups(packed));
+            }
+        }
+        removed.assign(
+            id_tracker.removed().begin(),
+            id_tracker.removed().end());
+
+        mixture.clear_dirty();
+        id_tracker.clear_changes();
+    }
+
+    // GroupMap is any map from global id to Group, such as a snapshot
+    // loaded into std::unordered_map<Id, Group>
+    template<class GroupMap>
+    void apply(GroupMap & groups) const {
+        for (const auto & pair : changed) {
+            auto i = groups.find(pair.first);
+            DIST_ASSERT(i != groups.end(), "missing group: " << pair.first);
+            i->second = pair.second;
+        }
+        for (Id global : removed) {
+            DIST_ASSERT(groups.erase(global), "missing group: " << global);
+        }
+        for (const auto & pair : added) {
+            DIST_ASSERT(groups.insert(pair).second,
+                "duplicate group: " << pair.first);
+        }
+    }
 };
 
 }   // namespace distributions
@@ -45,10 +45,16 @@ struct Group;
 struct Scorer;
 struct Sampler;
 struct MixtureDataScorer;
-struct MixtureValueScorer;
+template<class Score> struct MixtureValueScorer_;
+typedef MixtureValueScorer_<float> MixtureValueScorer;
 typedef MixtureSlave<Model, MixtureDataScorer> SmallMixture;
 typedef MixtureSlave<Model, MixtureDataScorer, MixtureValueScorer> FastMixture;
 typedef FastMixture Mixture;
+// opt-in mixtures caching scores in 16 bits; see float16.hpp
+typedef MixtureSlave<Model, MixtureDataScorer, MixtureValueScorer_<bfloat16_t>>
+    BFloat16Mixture;
+typedef MixtureSlave<Model, MixtureDataScorer, MixtureValueScorer_<float16_t>>
+    Float16Mixture;
 
 
 struct Shared : SharedMixin<Model> {
@@ -214,7 +220,7 @@ struct MixtureDataScorer
                + fast_lgamma(shared.alpha + shared.beta)
                - fast_lgamma(shared.alpha)
                - fast_lgamma(shared.beta);
-        float score = 0;
+        double score = 0;
         for (auto const & group : groups) {
             float alpha = shared.alpha + group.heads;
             float beta = shared.beta + group.tails;
@@ -228,7 +234,10 @@ struct MixtureDataScorer
     }
 };
 
-struct MixtureValueScorer : MixtureSlaveValueScorerMixin<Model> {
+template<class Score>
+struct MixtureValueScorer_ : MixtureSlaveValueScorerMixin<Model> {
+    typedef typename ScoreVector<Score>::type Scores;
+
     void resize(const Shared &, size_t size) {
         heads_scores_.resize(size);
         tails_scores_.resize(size);
@@ -249,6 +258,7 @@ struct MixtureValueScorer : MixtureSlaveValueScorerMixin<Model> {
             size_t groupid,
             const Group & group,
             rng_t & rng) {
+        DIST_INSTRUMENT_COUNT(UPDATE_GROUP);
         Scorer scorer;
         scorer.init(shared, group, rng);
         heads_scores_[groupid] = scorer.heads_score;
@@ -277,18 +287,21 @@ struct MixtureValueScorer : MixtureSlaveValueScorerMixin<Model> {
             const Shared & shared,
             const std::vector<Group> & groups,
             rng_t &) {
+        DIST_INSTRUMENT_COUNT(UPDATE_ALL);
         const size_t group_count = groups.size();
         heads_scores_.resize(group_count);
         tails_scores_.resize(group_count);
+        VectorFloat heads_probs(group_count);
+        VectorFloat tails_probs(group_count);
         for (size_t groupid = 0; groupid < group_count; ++groupid) {
             const Group & group = groups[groupid];
             float heads = shared.alpha + group.heads;
             float tails = shared.beta + group.tails;
-            heads_scores_[groupid] = heads / (heads + tails);
-            tails_scores_[groupid] = tails / (heads + tails);
+            heads_probs[groupid] = heads / (heads + tails);
+            tails_probs[groupid] = tails / (heads + tails);
         }
-        vector_log(group_count, heads_scores_.data());
-        vector_log(group_count, tails_scores_.data());
+        vector_log(group_count, heads_probs.data(), heads_scores_.data());
+        vector_log(group_count, tails_probs.data(), tails_scores_.data());
     }
 
     float score_value_group(
@@ -319,9 +332,20 @@ struct MixtureValueScorer : MixtureSlaveValueScorerMixin<Model> {
         DIST_ASSERT_EQ(tails_scores_.size(), groups.size());
     }
 
+    void reserve(size_t capacity) {
+        heads_scores_.reserve(capacity);
+        tails_scores_.reserve(capacity);
+    }
+
+    size_t memory_usage() const {
+        return sizeof(*this)
+             + heap_bytes(heads_scores_)
+             + heap_bytes(tails_scores_);
+    }
+
   private:
-    VectorFloat heads_scores_;
-    VectorFloat tails_scores_;
+    Scores heads_scores_;
+    Scores tails_scores_;
 };
 };  // struct BetaBernoulli
 }   // namespace distributions
@@ -32,6 +32,7 @@
 #include <distributions/special.hpp>
 #include <distributions/random.hpp>
 #include <distributions/vector.hpp>
+#include <distributions/vector_math.hpp>
 #include <distributions/mixins.hpp>
 #include <distributions/mixture.hpp>
 
@@ -228,7 +229,7 @@ struct MixtureDataScorer
         const float shared_part = fast_lgamma(shared.alpha + shared.beta)
                                 - fast_lgamma(shared.alpha)
                                 - fast_lgamma(shared.beta);
-        float score = 0;
+        double score = 0;
         for (auto const & group : groups) {
             if (group.count) {
                 Shared post = shared.plus_group(group);
@@ -247,18 +248,21 @@ struct MixtureValueScorer : MixtureSlaveValueScorerMixin<Model> {
         score_.resize(size);
         post_beta_.resize(size);
         alpha_.resize(size);
+        table_.resize(size);
     }
 
     void add_group(const Shared &, rng_t &) {
         score_.packed_add();
         post_beta_.packed_add();
         alpha_.packed_add();
+        table_.add_group(score_group());
     }
 
     void remove_group(const Shared &, size_t groupid) {
         score_.packed_remove(groupid);
         post_beta_.packed_remove(groupid);
         alpha_.packed_remove(groupid);
+        table_.remove_group(groupid);
     }
 
     void update_group(
@@ -266,21 +270,24 @@ struct MixtureValueScorer : MixtureSlaveValueScorerMixin<Model> {
             size_t groupid,
             const Group & group,
             rng_t & rng) {
+        DIST_INSTRUMENT_COUNT(UPDATE_GROUP);
         Model::Scorer base;
         base.init(shared, group, rng);
 
         score_[groupid] = base.score;
         post_beta_[groupid] = base.post_beta;
         alpha_[groupid] = base.alpha;
+        table_.update_group(groupid, score_group());
     }
 
     void add_value(
             const Shared & shared,
             size_t groupid,
             const Group & group,
-            const Value &,
+            const Value & value,
             rng_t & rng) {
         update_group(shared, groupid, group, rng);
+        table_.add_row(value, score_group());
     }
 
     void remove_value(
@@ -296,6 +303,7 @@ struct MixtureValueScorer : MixtureSlaveValueScorerMixin<Model> {
             const Shared & shared,
             const std::vector<Group> & groups,
             rng_t & rng) {
+        DIST_INSTRUMENT_COUNT(UPDATE_ALL);
         const size_t group_count = groups.size();
         for (size_t groupid = 0; groupid < group_count; ++groupid) {
             update_group(shared, groupid, groups[groupid], rng);
@@ -308,9 +316,7 @@ struct MixtureValueScorer : MixtureSlaveValueScorerMixin<Model> {
             size_t groupid,
             const Value & value,
             rng_t &) const {
-        float beta = post_beta_[groupid] + value;
-        return score_[groupid] + fast_lgamma(beta)
-                               - fast_lgamma(beta + alpha_[groupid]);
+        return _score_value_group(groupid, value);
     }
 
     void score_value(
@@ -319,6 +325,15 @@ struct MixtureValueScorer : MixtureSlaveValueScorerMixin<Model> {
             const Value & value,
             AlignedFloats scores_accum,
             rng_t &) const {
+        const float * row = table_.row(value);
+        if (DIST_LIKELY(row)) {
+            vector_add(
+                scores_accum.size(),
+                VectorFloat_data(scores_accum),
+                row);
+            return;
+        }
+
         for (size_t i = 0, size = scores_accum.size(); i < size; ++i) {
             float beta = post_beta_[i] + value;
             scores_accum[i] += score_[i] + fast_lgamma(beta)
@@ -332,12 +347,44 @@ struct MixtureValueScorer : MixtureSlaveValueScorerMixin<Model> {
         DIST_ASSERT_EQ(score_.size(), groups.size());
         DIST_ASSERT_EQ(post_beta_.size(), groups.size());
         DIST_ASSERT_EQ(alpha_.size(), groups.size());
+        table_.validate(groups.size());
+    }
+
+    void reserve(size_t capacity) {
+        score_.reserve(capacity);
+        post_beta_.reserve(capacity);
+        alpha_.reserve(capacity);
+        table_.reserve(capacity);
+    }
+
+    size_t memory_usage() const {
+        return sizeof(*this)
+             + heap_bytes(score_)
+             + heap_bytes(post_beta_)
+             + heap_bytes(alpha_)
+             + heap_bytes(table_);
     }
 
   private:
+    float _score_value_group(size_t groupid, const Value & value) const {
+        float beta = post_beta_[groupid] + value;
+        return score_[groupid] + fast_lgamma(beta)
+                               - fast_lgamma(beta + alpha_[groupid]);
+    }
+
+    struct ScoreGroup {
+        const MixtureValueScorer * scorer;
+        float operator()(size_t groupid, uint32_t value) const {
+            return scorer->_score_value_group(groupid, value);
+        }
+    };
+
+    ScoreGroup score_group() const { return ScoreGroup{this}; }
+
     VectorFloat score_;
     VectorFloat post_beta_;
     VectorFloat alpha_;
+    MixtureValueTable table_;
 };
 };  // struct BetaNegativeBinomial
 }   // namespace distributions
@@ -48,10 +48,16 @@ struct Group;
 struct Scorer;
 struct Sampler;
 struct MixtureDataScorer;
-struct MixtureValueScorer;
+template<class Score> struct MixtureValueScorer_;
+typedef MixtureValueScorer_<float> MixtureValueScorer;
 typedef MixtureSlave<Model, MixtureDataScorer> SmallMixture;
 typedef MixtureSlave<Model, MixtureDataScorer, MixtureValueScorer> FastMixture;
 typedef FastMixture Mixture;
+// opt-in mixtures caching scores in 16 bits; see float16.hpp
+typedef MixtureSlave<Model, MixtureDataScorer, MixtureValueScorer_<bfloat16_t>>
+    BFloat16Mixture;
+typedef MixtureSlave<Model, MixtureDataScorer, MixtureValueScorer_<float16_t>>
+    Float16Mixture;
 
 
 struct Shared : SharedMixin<Model> {
@@ -283,6 +289,10 @@ struct MixtureDataScorer
         }
     }
 
+    size_t memory_usage() const {
+        return sizeof(*this) + heap_bytes(shared_part_) + heap_bytes(scores_);
+    }
+
   private:
     void _init(
             const Shared & shared,
@@ -340,10 +350,13 @@ struct MixtureDataScorer
 
     mutable double alpha_sum_;
     mutable VectorFloat shared_part_;
-    mutable VectorFloat scores_;
+    mutable std::vector<double> scores_;  // double to sum over many groups
 };
 
-struct MixtureValueScorer : MixtureSlaveValueScorerMixin<Model> {
+template<class Score>
+struct MixtureValueScorer_ : MixtureSlaveValueScorerMixin<Model> {
+    typedef typename ScoreVector<Score>::type Scores;
+
     void resize(const Shared & shared, size_t size) {
         scores_shift_.resize(size);
         scores_.resize(shared.dim);
@@ -371,6 +384,7 @@ struct MixtureValueScorer : MixtureSlaveValueScorerMixin<Model> {
             size_t groupid,
             const Group & group,
             rng_t &) {
+        DIST_INSTRUMENT_COUNT(UPDATE_GROUP);
         scores_shift_[groupid] = fast_log(alpha_sum_ + group.count_sum);
         for (Value value = 0; value < shared.dim; ++value) {
             scores_[value][groupid] =
@@ -400,6 +414,7 @@ struct MixtureValueScorer : MixtureSlaveValueScorerMixin<Model> {
             const Shared & shared,
             const std::vector<Group> & groups,
             rng_t &) {
+        DIST_INSTRUMENT_COUNT(UPDATE_ALL);
         const size_t group_count = groups.size();
 
         alpha_sum_ = 0;
@@ -407,16 +422,16 @@ struct MixtureValueScorer : MixtureSlaveValueScorerMixin<Model> {
             alpha_sum_ += shared.alphas[value];
         }
         for (size_t groupid = 0; groupid < group_count; ++groupid) {
-            const Group & group = groups[groupid];
-            for (Value value = 0; value < shared.dim; ++value) {
-                scores_[value][groupid] =
-                    shared.alphas[value] + group.counts[value];
-            }
-            scores_shift_[groupid] = alpha_sum_ + group.count_sum;
+            scores_shift_[groupid] = alpha_sum_ + groups[groupid].count_sum;
         }
         vector_log(group_count, scores_shift_.data());
+        VectorFloat counts(group_count);
         for (Value value = 0; value < shared.dim; ++value) {
-            vector_log(group_count, scores_[value].data());
+            const float alpha = shared.alphas[value];
+            for (size_t groupid = 0; groupid < group_count; ++groupid) {
+                counts[groupid] = alpha + groups[groupid].counts[value];
+            }
+            vector_log(group_count, counts.data(), scores_[value].data());
         }
     }
 
@@ -454,6 +469,19 @@ struct MixtureValueScorer : MixtureSlaveValueScorerMixin<Model> {
         DIST_ASSERT_EQ(scores_shift_.size(), groups.size());
     }
 
+    void reserve(size_t capacity) {
+        scores_shift_.reserve(capacity);
+        for (auto & scores : scores_) {
+            scores.reserve(capacity);
+        }
+    }
+
+    size_t memory_usage() const {
+        return sizeof(*this)
+             + heap_bytes(scores_)
+             + heap_bytes(scores_shift_);
+    }
+
   private:
     void _update_group_value(
             const Shared & shared,
@@ -467,7 +495,7 @@ struct MixtureValueScorer : MixtureSlaveValueScorerMixin<Model> {
     }
 
     float alpha_sum_;
-    std::vector<VectorFloat> scores_;
+    std::vector<Scores> scores_;
     VectorFloat scores_shift_;
 };
 };  // struct DirichletDiscrete
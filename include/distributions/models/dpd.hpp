@@ -150,6 +150,10 @@ struct Shared : SharedMixin<Model> {
         }
         return shared;
     }
+
+    size_t memory_usage() const {
+        return sizeof(*this) + heap_bytes(betas) + heap_bytes(counts);
+    }
 };
 
 // Group supports data debt, i.e., negative counts.
@@ -157,6 +161,10 @@ struct Shared : SharedMixin<Model> {
 struct Group : GroupMixin<Model> {
     SparseCounter<Value, count_t> counts;
 
+    size_t memory_usage() const {
+        return sizeof(*this) + heap_bytes(counts);
+    }
+
     template<class Message>
     void protobuf_load(const Message & message) {
         if (DIST_DEBUG_LEVEL >= 1) {
@@ -355,7 +363,7 @@ struct MixtureDataScorer
         }
         const float shared_total = fast_lgamma(alpha);
 
-        float score = 0;
+        double score = 0;
         for (auto const & group : groups) {
             if (group.counts.get_total()) {
                 for (auto & i : group.counts) {
@@ -416,6 +424,7 @@ struct MixtureValueScorer : MixtureSlaveValueScorerMixin<Model> {
             size_t groupid,
             const Group & group,
             rng_t &) {
+        DIST_INSTRUMENT_COUNT(UPDATE_GROUP);
         const float alpha = shared.alpha;
         for (auto & i : scores_) {
             Value value = i.first;
@@ -472,6 +481,7 @@ struct MixtureValueScorer : MixtureSlaveValueScorerMixin<Model> {
             const Shared & shared,
             const std::vector<Group> & groups,
             rng_t &) {
+        DIST_INSTRUMENT_COUNT(UPDATE_ALL);
         _validate(shared, groups.size());
         const size_t group_count = groups.size();
         const float alpha = shared.alpha;
@@ -561,6 +571,19 @@ struct MixtureValueScorer : MixtureSlaveValueScorerMixin<Model> {
         validate(shared, groups.size());
     }
 
+    void reserve(size_t capacity) {
+        scores_shift_.reserve(capacity);
+        for (auto & i : scores_) {
+            i.second.scores.reserve(capacity);
+        }
+    }
+
+    size_t memory_usage() const {
+        return sizeof(*this)
+             + heap_bytes(scores_)
+             + heap_bytes(scores_shift_);
+    }
+
   private:
     void _validate(const Shared & shared, size_t group_count) const {
         if (DIST_DEBUG_LEVEL >= 3) {
@@ -572,6 +595,10 @@ struct MixtureValueScorer : MixtureSlaveValueScorerMixin<Model> {
         uint32_t ref_count;
         VectorFloat scores;
         CountAndScores() : ref_count(0), scores() {}
+
+        size_t memory_usage() const {
+            return sizeof(*this) + heap_bytes(scores);
+        }
     };
     Sparse_<Value, CountAndScores> scores_;
     VectorFloat scores_shift_;
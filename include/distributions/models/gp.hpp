@@ -226,7 +226,7 @@ struct MixtureDataScorer
         const float alpha_part = fast_lgamma(shared.alpha);
         const float beta_part = shared.alpha * fast_log(shared.inv_beta);
 
-        float score = 0;
+        double score = 0;
         for (auto const & group : groups) {
             if (group.count) {
                 Shared post = shared.plus_group(group);
@@ -245,18 +245,21 @@ struct MixtureValueScorer : MixtureSlaveValueScorerMixin<Model> {
         score_.resize(size);
         post_alpha_.resize(size);
         score_coeff_.resize(size);
+        table_.resize(size);
     }
 
     void add_group(const Shared &, rng_t &) {
         score_.packed_add();
         post_alpha_.packed_add();
         score_coeff_.packed_add();
+        table_.add_group(score_group());
     }
 
     void remove_group(const Shared &, size_t groupid) {
         score_.packed_remove(groupid);
         post_alpha_.packed_remove(groupid);
         score_coeff_.packed_remove(groupid);
+        table_.remove_group(groupid);
     }
 
     void update_group(
@@ -264,21 +267,24 @@ struct MixtureValueScorer : MixtureSlaveValueScorerMixin<Model> {
             size_t groupid,
             const Group & group,
             rng_t & rng) {
+        DIST_INSTRUMENT_COUNT(UPDATE_GROUP);
         Model::Scorer base;
         base.init(shared, group, rng);
 
         score_[groupid] = base.score;
         post_alpha_[groupid] = base.post_alpha;
         score_coeff_[groupid] = base.score_coeff;
+        table_.update_group(groupid, score_group());
     }
 
     void add_value(
             const Shared & shared,
             size_t groupid,
             const Group & group,
-            const Value &,
+            const Value & value,
             rng_t & rng) {
         update_group(shared, groupid, group, rng);
+        table_.add_row(value, score_group());
     }
 
     void remove_value(
@@ -294,6 +300,7 @@ struct MixtureValueScorer : MixtureSlaveValueScorerMixin<Model> {
             const Shared & shared,
             const std::vector<Group> & groups,
             rng_t & rng) {
+        DIST_INSTRUMENT_COUNT(UPDATE_ALL);
         const size_t group_count = groups.size();
         for (size_t groupid = 0; groupid < group_count; ++groupid) {
             update_group(shared, groupid, groups[groupid], rng);
@@ -306,10 +313,7 @@ struct MixtureValueScorer : MixtureSlaveValueScorerMixin<Model> {
             size_t groupid,
             const Value & value,
             rng_t &) const {
-        return score_[groupid]
-            + fast_lgamma(post_alpha_[groupid] + value)
-            - fast_log_factorial(value)
-            + score_coeff_[groupid] * value;
+        return _score_value_group(groupid, value);
     }
 
     void score_value(
@@ -319,18 +323,59 @@ struct MixtureValueScorer : MixtureSlaveValueScorerMixin<Model> {
             AlignedFloats scores_accum,
             rng_t &) const;
 
+    // scores_accum is a row-major values x groups matrix
+    void score_values(
+            const Shared &,
+            const std::vector<Group> &,
+            const std::vector<Value> & values,
+            AlignedFloats scores_accum,
+            rng_t &) const;
+
     void validate(
             const Shared &,
             const std::vector<Group> & groups) const {
         DIST_ASSERT_EQ(score_.size(), groups.size());
         DIST_ASSERT_EQ(post_alpha_.size(), groups.size());
         DIST_ASSERT_EQ(score_coeff_.size(), groups.size());
+        table_.validate(groups.size());
+    }
+
+    void reserve(size_t capacity) {
+        score_.reserve(capacity);
+        post_alpha_.reserve(capacity);
+        score_coeff_.reserve(capacity);
+        table_.reserve(capacity);
+    }
+
+    size_t memory_usage() const {
+        return sizeof(*this)
+             + heap_bytes(score_)
+             + heap_bytes(post_alpha_)
+             + heap_bytes(score_coeff_)
+             + heap_bytes(table_);
     }
 
   private:
+    float _score_value_group(size_t groupid, const Value & value) const {
+        return score_[groupid]
+            + fast_lgamma(post_alpha_[groupid] + value)
+            - fast_log_factorial(value)
+            + score_coeff_[groupid] * value;
+    }
+
+    struct ScoreGroup {
+        const MixtureValueScorer * scorer;
+        float operator()(size_t groupid, uint32_t value) const {
+            return scorer->_score_value_group(groupid, value);
+        }
+    };
+
+    ScoreGroup score_group() const { return ScoreGroup{this}; }
+
     VectorFloat score_;
     VectorFloat post_alpha_;
     VectorFloat score_coeff_;
+    MixtureValueTable table_;
 };
 };  // struct GammaPoisson
 }   // namespace distributions
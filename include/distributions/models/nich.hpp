@@ -43,10 +43,16 @@ struct Group;
 struct Scorer;
 struct Sampler;
 struct MixtureDataScorer;
-struct MixtureValueScorer;
+template<class Score> struct MixtureValueScorer_;
+typedef MixtureValueScorer_<float> MixtureValueScorer;
 typedef MixtureSlave<Model, MixtureDataScorer> SmallMixture;
 typedef MixtureSlave<Model, MixtureDataScorer, MixtureValueScorer> FastMixture;
 typedef FastMixture Mixture;
+// opt-in mixtures caching scores in 16 bits; see float16.hpp
+typedef MixtureSlave<Model, MixtureDataScorer, MixtureValueScorer_<bfloat16_t>>
+    BFloat16Mixture;
+typedef MixtureSlave<Model, MixtureDataScorer, MixtureValueScorer_<float16_t>>
+    Float16Mixture;
 
 
 struct Shared : SharedMixin<Model> {
@@ -271,7 +277,7 @@ struct MixtureDataScorer
             0.5f * shared.nu * fast_log(shared.nu * shared.sigmasq);
         const float log_pi = 1.1447298858493991f;
 
-        float score = 0;
+        double score = 0;
         for (auto const & group : groups) {
             if (group.count) {
                 Shared post = shared.plus_group(group);
@@ -287,7 +293,10 @@ struct MixtureDataScorer
     }
 };
 
-struct MixtureValueScorer : MixtureSlaveValueScorerMixin<Model> {
+template<class Score>
+struct MixtureValueScorer_ : MixtureSlaveValueScorerMixin<Model> {
+    typedef typename ScoreVector<Score>::type Scores;
+
     void resize(const Shared &, size_t size) {
         score_.resize(size);
         log_coeff_.resize(size);
@@ -314,6 +323,7 @@ struct MixtureValueScorer : MixtureSlaveValueScorerMixin<Model> {
             size_t groupid,
             const Group & group,
             rng_t & rng) {
+        DIST_INSTRUMENT_COUNT(UPDATE_GROUP);
         Model::Scorer base;
         base.init(shared, group, rng);
 
@@ -345,6 +355,7 @@ struct MixtureValueScorer : MixtureSlaveValueScorerMixin<Model> {
             const Shared & shared,
             const std::vector<Group> & groups,
             rng_t & rng) {
+        DIST_INSTRUMENT_COUNT(UPDATE_ALL);
         const size_t group_count = groups.size();
         for (size_t groupid = 0; groupid < group_count; ++groupid) {
             update_group(shared, groupid, groups[groupid], rng);
@@ -368,6 +379,14 @@ struct MixtureValueScorer : MixtureSlaveValueScorerMixin<Model> {
             AlignedFloats scores_accum,
             rng_t &) const;
 
+    // scores_accum is a row-major values x groups matrix
+    void score_values(
+            const Shared &,
+            const std::vector<Group> &,
+            const std::vector<Value> & values,
+            AlignedFloats scores_accum,
+            rng_t &) const;
+
     void validate(
             const Shared &,
             const std::vector<Group> & groups) const {
@@ -377,11 +396,26 @@ struct MixtureValueScorer : MixtureSlaveValueScorerMixin<Model> {
         DIST_ASSERT_EQ(mean_.size(), groups.size());
     }
 
+    void reserve(size_t capacity) {
+        score_.reserve(capacity);
+        log_coeff_.reserve(capacity);
+        precision_.reserve(capacity);
+        mean_.reserve(capacity);
+    }
+
+    size_t memory_usage() const {
+        return sizeof(*this)
+             + heap_bytes(score_)
+             + heap_bytes(log_coeff_)
+             + heap_bytes(precision_)
+             + heap_bytes(mean_);
+    }
+
   private:
-    VectorFloat score_;
-    VectorFloat log_coeff_;
-    VectorFloat precision_;
-    VectorFloat mean_;
+    Scores score_;
+    Scores log_coeff_;
+    Scores precision_;
+    Scores mean_;
 };
 };  // struct NormalInverseChiSq
 }   // namespace distributions
@@ -27,6 +27,8 @@
 
 #pragma once
 
+#include <stdint.h>
+#include <atomic>
 #include <distributions/common.hpp>
 #include <distributions/special.hpp>
 #include <distributions/random.hpp>
@@ -60,6 +62,50 @@ is_symmetric_positive_definite(const Matrix &m) {
     return ldlt.isPositive();
 }
 
+template <typename Matrix>
+static inline float
+log_det_from_llt(const Eigen::LLT<Matrix> & llt) {
+    float log_det = 0;
+    const auto & factor = llt.matrixLLT();
+    for (int i = 0, size = factor.rows(); i < size; ++i) {
+        log_det += fast_log(factor(i, i));
+    }
+    return 2.f * log_det;
+}
+
+// Dynamic-size Eigen matrices and factorizations own rows * cols scalars
+// on the heap; fixed-size ones are stored inline.
+template<class Scalar, int Rows, int Cols, int Options, int MaxRows,
+         int MaxCols>
+struct HeapBytes<
+        Eigen::Matrix<Scalar, Rows, Cols, Options, MaxRows, MaxCols>> {
+    typedef Eigen::Matrix<Scalar, Rows, Cols, Options, MaxRows, MaxCols>
+        Matrix;
+    static size_t get(const Matrix & matrix) {
+        const bool dynamic =
+            (Rows == Eigen::Dynamic or Cols == Eigen::Dynamic);
+        return dynamic ? matrix.size() * sizeof(Scalar) : 0;
+    }
+};
+
+template<class MatrixType, int UpLo>
+struct HeapBytes<Eigen::LLT<MatrixType, UpLo>> {
+    static size_t get(const Eigen::LLT<MatrixType, UpLo> & llt) {
+        typedef typename MatrixType::Scalar Scalar;
+        const bool dynamic = (
+            MatrixType::RowsAtCompileTime == Eigen::Dynamic or
+            MatrixType::ColsAtCompileTime == Eigen::Dynamic);
+        return dynamic ? llt.rows() * llt.cols() * sizeof(Scalar) : 0;
+    }
+};
+
+// Versions identify values of NormalInverseWishart Shareds, across all
+// dimensions and threads.  Zero is never a valid version.
+inline uint64_t next_niw_shared_version() {
+    static std::atomic<uint64_t> version(0);
+    return ++version;
+}
+
 template<int dim_ = -1>
 struct NormalInverseWishart {
 static_assert(dim_ == -1 || dim_ > 0, "invalid dimension");
@@ -72,13 +118,47 @@ typedef Vector Value;
 struct Group;
 struct Scorer;
 struct Sampler;
+struct MixtureDataScorer;
+struct MixtureValueScorer;
+typedef MixtureSlave<Model, MixtureDataScorer> SmallMixture;
+typedef MixtureSlave<Model, MixtureDataScorer, MixtureValueScorer> FastMixture;
+typedef FastMixture Mixture;
 
 struct Shared : SharedMixin<Model> {
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
     Vector mu;
     float kappa;
     Matrix psi;
     float nu;
 
+    // Groups key their cached posterior factors on version, rather than
+    // on copies of mu, kappa and psi.  Every construction, copy and
+    // protobuf_load() takes a new version; code that assigns mu, kappa or
+    // psi in place must call changed() before scoring again.
+    uint64_t version;
+
+    Shared() : version(next_niw_shared_version()) {}
+
+    Shared(const Shared & other) :
+        mu(other.mu),
+        kappa(other.kappa),
+        psi(other.psi),
+        nu(other.nu),
+        version(next_niw_shared_version())
+    {}
+
+    Shared & operator=(const Shared & other) {
+        mu = other.mu;
+        kappa = other.kappa;
+        psi = other.psi;
+        nu = other.nu;
+        changed();
+        return *this;
+    }
+
+    void changed() { version = next_niw_shared_version(); }
+
     Shared plus_group(const Group & group) const {
         Shared post;
         DIST_ASSERT3(dim() > 0, "uninitialized");
@@ -102,6 +182,10 @@ struct Shared : SharedMixin<Model> {
         return post;
     }
 
+    size_t memory_usage() const {
+        return sizeof(*this) + heap_bytes(mu) + heap_bytes(psi);
+    }
+
     template<class Message>
     void protobuf_load(const Message & message) {
         // mu
@@ -131,6 +215,8 @@ struct Shared : SharedMixin<Model> {
         // nu
         DIST_ASSERT_GT(message.nu(), static_cast<float>(dim) - 1.);
         nu = message.nu();
+
+        changed();
     }
 
     template<class Message>
@@ -185,10 +271,46 @@ struct Shared : SharedMixin<Model> {
 };
 
 struct Group : GroupMixin<Model> {
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
     int count;
     Vector sum_x;
     Matrix sum_xxT;
 
+    // Cholesky factor of the posterior scale shared.plus_group(*this).psi,
+    // maintained by rank-1 updates in add_value() and remove_value().
+    // The factor is only used when scoring against the Shared version it
+    // was computed with; call invalidate_cache() after assigning
+    // statistics directly.
+    Eigen::LLT<Matrix> post_psi_llt;
+    float cache_shared_log_det_psi;
+    uint64_t cache_version = 0;
+
+    void update_cache(const Shared & shared) {
+        post_psi_llt.compute(shared.plus_group(*this).psi);
+        cache_shared_log_det_psi =
+            log_det_from_llt(Eigen::LLT<Matrix>(shared.psi));
+        const bool success = (post_psi_llt.info() == Eigen::Success);
+        cache_version = success ? shared.version : 0;
+    }
+
+    void invalidate_cache() { cache_version = 0; }
+
+    size_t memory_usage() const {
+        return sizeof(*this)
+             + heap_bytes(sum_x)
+             + heap_bytes(sum_xxT)
+             + heap_bytes(post_psi_llt);
+    }
+
+    bool cache_is_current(const Shared & shared) const {
+        return cache_version == shared.version;
+    }
+
+    Vector post_mu(const Shared & shared) const {
+        return (shared.kappa * shared.mu + sum_x) / (shared.kappa + count);
+    }
+
     template<class Message>
     void protobuf_load(const Message & message) {
         // count
@@ -213,6 +335,8 @@ struct Group : GroupMixin<Model> {
         // XXX(stephentu): should also assert positive semi-definite
         DIST_ASSERT3(is_symmetric(sum_xxT), "expected sym matrix");
         DIST_ASSERT_EQ(sum_x.rows(), sum_xxT.rows());
+
+        invalidate_cache();
     }
 
     template<class Message>
@@ -242,6 +366,7 @@ struct Group : GroupMixin<Model> {
         sum_x.setZero();
         sum_xxT.resize(shared.dim(), shared.dim());
         sum_xxT.setZero();
+        update_cache(shared);
     }
 
     void add_value(
@@ -249,9 +374,16 @@ struct Group : GroupMixin<Model> {
             const Value & value,
             rng_t &) {
         DIST_ASSERT3(shared.dim() == (size_t)value.size(), "dim mismatch");
+        if (DIST_LIKELY(cache_is_current(shared))) {
+            // psi' = psi + kappa / (kappa + 1) (x - mu) (x - mu)^T
+            const float post_kappa = shared.kappa + count;
+            const Vector diff = value - post_mu(shared);
+            post_psi_llt.rankUpdate(diff, post_kappa / (post_kappa + 1));
+        }
         count++;
         sum_x += value;
         sum_xxT += value * value.transpose();
+        _validate_cache(shared);
     }
 
     void add_repeated_value(
@@ -260,9 +392,18 @@ struct Group : GroupMixin<Model> {
             const int & count,
             rng_t &) {
         DIST_ASSERT3(shared.dim() == (size_t)value.size(), "dim mismatch");
+        if (DIST_LIKELY(cache_is_current(shared))) {
+            // psi' = psi + kappa n / (kappa + n) (x - mu) (x - mu)^T
+            const float post_kappa = shared.kappa + this->count;
+            const Vector diff = value - post_mu(shared);
+            post_psi_llt.rankUpdate(
+                diff,
+                post_kappa * count / (post_kappa + count));
+        }
         this->count += count;
         sum_x += count * value;
         sum_xxT += count * (value * value.transpose());
+        _validate_cache(shared);
     }
 
     void remove_value(
@@ -273,15 +414,23 @@ struct Group : GroupMixin<Model> {
         count--;
         sum_x -= value;
         sum_xxT -= value * value.transpose();
+        if (DIST_LIKELY(cache_is_current(shared))) {
+            // psi' = psi - kappa' / (kappa' + 1) (x - mu') (x - mu')^T
+            const float post_kappa = shared.kappa + count;
+            const Vector diff = value - post_mu(shared);
+            post_psi_llt.rankUpdate(diff, -post_kappa / (post_kappa + 1));
+        }
+        _validate_cache(shared);
     }
 
     void merge(
-            const Shared &,
+            const Shared & shared,
             const Group & source,
             rng_t &) {
         count += source.count;
         sum_x += source.sum_x;
         sum_xxT += source.sum_xxT;
+        update_cache(shared);
     }
 
     float score_value(
@@ -296,15 +445,26 @@ struct Group : GroupMixin<Model> {
     float score_data(
             const Shared & shared,
             rng_t &) const {
-        Shared post = shared.plus_group(*this);
+        const float post_kappa = shared.kappa + count;
+        const float post_nu = shared.nu + count;
+        float shared_log_det;
+        float post_log_det;
+        if (DIST_LIKELY(cache_is_current(shared))) {
+            shared_log_det = cache_shared_log_det_psi;
+            post_log_det = log_det_from_llt(post_psi_llt);
+        } else {
+            shared_log_det = log_det_from_llt(Eigen::LLT<Matrix>(shared.psi));
+            post_log_det = log_det_from_llt(
+                Eigen::LLT<Matrix>(shared.plus_group(*this).psi));
+        }
         const float log_pi = 1.1447298858494002;
-        return lmultigamma(shared.dim(), post.nu * 0.5)
-            + shared.nu * 0.5 * fast_log(shared.psi.determinant())
+        return lmultigamma(shared.dim(), post_nu * 0.5)
+            + shared.nu * 0.5 * shared_log_det
             - static_cast<float>(count * shared.dim()) * 0.5 * log_pi
             - lmultigamma(shared.dim(), shared.nu * 0.5)
-            - post.nu * 0.5 * fast_log(post.psi.determinant())
+            - post_nu * 0.5 * post_log_det
             + static_cast<float>(shared.dim())
-              * 0.5 * fast_log(shared.kappa / post.kappa);
+              * 0.5 * fast_log(shared.kappa / post_kappa);
     }
 
     Value sample_value(
@@ -315,10 +475,31 @@ struct Group : GroupMixin<Model> {
         return sampler.eval(shared, rng);
     }
 
-    void validate(const Shared & shared) const { }
+    void validate(const Shared & shared) const {
+        if (cache_is_current(shared)) {
+            const Matrix post_psi = shared.plus_group(*this).psi;
+            const Matrix L = post_psi_llt.matrixL();
+            DIST_ASSERT(
+                (L * L.transpose()).isApprox(post_psi, 1e-3f),
+                "stale cholesky factor");
+        }
+    }
+
+  private:
+    void _validate_cache(const Shared & shared) {
+        if (DIST_UNLIKELY(not cache_is_current(shared)) or
+                DIST_UNLIKELY(post_psi_llt.info() != Eigen::Success)) {
+            update_cache(shared);
+        }
+        if (DIST_DEBUG_LEVEL >= 3) {
+            validate(shared);
+        }
+    }
 };
 
 struct Sampler {
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
     Vector mu;
     Matrix cov;
 
@@ -329,8 +510,8 @@ struct Sampler {
         Shared post = shared.plus_group(group);
         auto p = sample_normal_inverse_wishart(
                 post.mu, post.kappa, post.psi, post.nu, rng);
-        mu.swap(p.first);
-        cov.swap(p.second);
+        mu = std::move(p.first);
+        cov = std::move(p.second);
     }
 
     Value eval(
@@ -341,28 +522,454 @@ struct Sampler {
 };
 
 struct Scorer {
-    Shared post;
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    Vector mu;
+    Matrix chol;
+    float score;
+    float dof;
+    float quad_scale;
 
     void init(
             const Shared & shared,
             const Group & group,
             rng_t &) {
-        post = shared.plus_group(group);
+        const float d = shared.dim();
+        const float post_kappa = shared.kappa + group.count;
+        dof = shared.nu + group.count - d + 1.f;
+        mu = group.post_mu(shared);
+
+        // sigma = psi (kappa + 1) / (kappa dof), so that
+        // (x - mu)^T sigma^-1 (x - mu) = quad_scale |chol^-1 (x - mu)|^2
+        float log_det_psi;
+        if (DIST_LIKELY(group.cache_is_current(shared))) {
+            chol = group.post_psi_llt.matrixL();
+            log_det_psi = log_det_from_llt(group.post_psi_llt);
+        } else {
+            Eigen::LLT<Matrix> llt(shared.plus_group(group).psi);
+            chol = llt.matrixL();
+            log_det_psi = log_det_from_llt(llt);
+        }
+        const float sigma_scale = (post_kappa + 1.f) / (post_kappa * dof);
+        quad_scale = 1.f / sigma_scale;
+
+        const float log_pi = 1.1447298858494002;
+        const float log_det_sigma = log_det_psi + d * fast_log(sigma_scale);
+        score = fast_lgamma(0.5f * (dof + d)) - fast_lgamma(0.5f * dof)
+              - 0.5f * log_det_sigma
+              - 0.5f * d * (fast_log(dof) + log_pi);
     }
 
     float eval(
             const Shared & shared,
             const Value & value,
             rng_t &) const {
-        const float dof = post.nu - static_cast<float>(shared.dim()) + 1.;
-        const Matrix sigma = post.psi * (post.kappa + 1.) / (post.kappa * dof);
-        return score_mv_student_t(value, dof, post.mu, sigma);
+        const float d = shared.dim();
+        const Vector diff = value - mu;
+        const float quad = quad_scale *
+            chol.template triangularView<Eigen::Lower>()
+                .solve(diff).squaredNorm();
+        return score - 0.5f * (dof + d) * fast_log(1.f + quad / dof);
+    }
+};
+
+struct MixtureDataScorer
+    : MixtureSlaveDataScorerMixin<Model, MixtureDataScorer> {
+    float score_data(
+            const Shared & shared,
+            const std::vector<Group> & groups,
+            rng_t &) const {
+        const unsigned d = shared.dim();
+        const float log_pi = 1.1447298858494002;
+        const float nu_part = lmultigamma(d, shared.nu * 0.5f);
+        const float psi_part = shared.nu * 0.5f *
+            log_det_from_llt(Eigen::LLT<Matrix>(shared.psi));
+
+        double score = 0;
+        for (auto const & group : groups) {
+            if (group.count) {
+                const float post_kappa = shared.kappa + group.count;
+                const float post_nu = shared.nu + group.count;
+                float post_log_det;
+                if (DIST_LIKELY(group.cache_is_current(shared))) {
+                    post_log_det = log_det_from_llt(group.post_psi_llt);
+                } else {
+                    post_log_det = log_det_from_llt(
+                        Eigen::LLT<Matrix>(shared.plus_group(group).psi));
+                }
+                score += lmultigamma(d, post_nu * 0.5f) - nu_part;
+                score += psi_part - post_nu * 0.5f * post_log_det;
+                score += -0.5f * log_pi * (group.count * d);
+                score += 0.5f * d * fast_log(shared.kappa / post_kappa);
+            }
+        }
+
+        return score;
+    }
+};
+
+struct MixtureValueScorer : MixtureSlaveValueScorerMixin<Model> {
+    typedef Eigen::Matrix<double, dim_, dim_> MatrixD;
+    typedef Eigen::Matrix<double, dim_, 1> VectorD;
+    typedef Packed_<MatrixD, Eigen::aligned_allocator<MatrixD>> Matrices;
+    typedef Packed_<double, aligned_allocator<double>> Weights;
+    typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic,
+                          Eigen::RowMajor> RowMajorMatrix;
+    typedef Eigen::Map<const RowMajorMatrix, Eigen::Aligned> ConstWeightsMap;
+    typedef Eigen::Map<const Eigen::VectorXd> ConstRow;
+
+    // Each group keeps psi_inv = inverse posterior scale and its log-det,
+    // refreshed by Sherman-Morrison rank-1 updates on add/remove_value.
+    // To guard against drift, a group is refactored from scratch every
+    // refresh_period updates, or when an update is ill-conditioned.
+    //
+    // The student-t quadratic form of every group is evaluated at once as
+    // weights * features(x), where in coordinates y = x - shared.mu,
+    //   features(y) = [y_i y_j for i <= j, y, 1]
+    // and row g of weights holds the matching coefficients of
+    //   scale_g (y - m_g)^T psi_inv_g (y - m_g).
+    // The expanded terms grow with |y|^2 but cancel to a quadratic form
+    // of order one for values near m_g, so psi_inv, weights and features
+    // are kept in double; in float, groups far from shared.mu lose all
+    // precision.
+    enum { refresh_period = 64 };
+
+    void resize(const Shared & shared, size_t size) {
+        feature_count_ = _feature_count(shared.dim());
+        score_.resize(size);
+        log_coeff_.resize(size);
+        log_det_.resize(size);
+        update_count_.resize(size);
+        psi_inv_.resize(size, shared.psi.template cast<double>());
+        weights_.resize(size * feature_count_);
+    }
+
+    void add_group(const Shared & shared, rng_t &) {
+        score_.packed_add();
+        log_coeff_.packed_add();
+        log_det_.packed_add();
+        update_count_.packed_add();
+        psi_inv_.packed_add(shared.psi.template cast<double>());
+        weights_.resize(weights_.size() + feature_count_);
+    }
+
+    void remove_group(const Shared &, size_t groupid) {
+        score_.packed_remove(groupid);
+        log_coeff_.packed_remove(groupid);
+        log_det_.packed_remove(groupid);
+        update_count_.packed_remove(groupid);
+        psi_inv_.packed_remove(groupid);
+
+        const size_t size = weights_.size() - feature_count_;
+        std::copy(
+            weights_.begin() + size,
+            weights_.end(),
+            weights_.begin() + groupid * feature_count_);
+        weights_.resize(size);
+    }
+
+    void update_group(
+            const Shared & shared,
+            size_t groupid,
+            const Group & group,
+            rng_t &) {
+        DIST_INSTRUMENT_COUNT(UPDATE_GROUP);
+        if (DIST_LIKELY(group.cache_is_current(shared))) {
+            _refactor(groupid, group.post_psi_llt);
+        } else {
+            _refactor(
+                groupid,
+                Eigen::LLT<Matrix>(shared.plus_group(group).psi));
+        }
+        _update_weights(shared, groupid, group);
+    }
+
+    void add_value(
+            const Shared & shared,
+            size_t groupid,
+            const Group & group,
+            const Value & value,
+            rng_t & rng) {
+        // group already contains value; undo it to recover the prior mean
+        const double post_kappa = shared.kappa + group.count - 1;
+        const VectorD prev_mu = (
+                shared.kappa * shared.mu.template cast<double>()
+                + group.sum_x.template cast<double>()
+                - value.template cast<double>()
+            ) / post_kappa;
+        const VectorD diff = value.template cast<double>() - prev_mu;
+        _rank_one_update(
+            shared,
+            groupid,
+            group,
+            diff,
+            post_kappa / (post_kappa + 1),
+            rng);
+    }
+
+    void remove_value(
+            const Shared & shared,
+            size_t groupid,
+            const Group & group,
+            const Value & value,
+            rng_t & rng) {
+        const double post_kappa = shared.kappa + group.count;
+        const VectorD diff =
+            value.template cast<double>() - _post_mu(shared, group);
+        _rank_one_update(
+            shared,
+            groupid,
+            group,
+            diff,
+            -post_kappa / (post_kappa + 1),
+            rng);
+    }
+
+    void update_all(
+            const Shared & shared,
+            const std::vector<Group> & groups,
+            rng_t & rng) {
+        DIST_INSTRUMENT_COUNT(UPDATE_ALL);
+        const size_t group_count = groups.size();
+        for (size_t groupid = 0; groupid < group_count; ++groupid) {
+            update_group(shared, groupid, groups[groupid], rng);
+        }
+    }
+
+    float score_value_group(
+            const Shared & shared,
+            const std::vector<Group> &,
+            size_t groupid,
+            const Value & value,
+            rng_t &) const {
+        const Eigen::VectorXd features = _features(shared, value);
+        const float quad = ConstRow(
+            weights_.data() + groupid * feature_count_,
+            feature_count_).dot(features);
+        return score_[groupid] + log_coeff_[groupid] * fast_log(1.f + quad);
     }
+
+    void score_value(
+            const Shared & shared,
+            const std::vector<Group> &,
+            const Value & value,
+            AlignedFloats scores_accum,
+            rng_t &) const {
+        const size_t size = scores_accum.size();
+
+        static thread_local VectorFloat * temp_ = nullptr;
+        static thread_local Eigen::VectorXd * quad_ = nullptr;
+        if (DIST_UNLIKELY(not temp_)) {
+            temp_ = new VectorFloat(size);  // never freed
+            quad_ = new Eigen::VectorXd(size);  // never freed
+        } else {
+            temp_->resize(size);
+        }
+
+        Eigen::VectorXd & quad = *quad_;
+        quad.noalias() = _weights(size) * _features(shared, value);
+        float * __restrict__ temp = VectorFloat_data(*temp_);
+        for (size_t i = 0; i < size; ++i) {
+            temp[i] = 1.f + static_cast<float>(quad(i));
+        }
+        vector_log(size, temp);
+
+        float * __restrict__ scores_accum_noalias =
+            VectorFloat_data(scores_accum);
+        const float * __restrict__ score = VectorFloat_data(score_);
+        const float * __restrict__ log_coeff = VectorFloat_data(log_coeff_);
+        for (size_t i = 0; i < size; ++i) {
+            scores_accum_noalias[i] += score[i] + log_coeff[i] * temp[i];
+        }
+    }
+
+    // scores_accum is a row-major values x groups matrix
+    void score_values(
+            const Shared & shared,
+            const std::vector<Group> & groups,
+            const std::vector<Value> & values,
+            AlignedFloats scores_accum,
+            rng_t &) const {
+        const size_t group_count = groups.size();
+        const size_t value_count = values.size();
+        if (DIST_DEBUG_LEVEL >= 2) {
+            DIST_ASSERT_EQ(scores_accum.size(), value_count * group_count);
+        }
+
+        Eigen::MatrixXd features(feature_count_, value_count);
+        for (size_t v = 0; v < value_count; ++v) {
+            features.col(v) = _features(shared, values[v]);
+        }
+        const RowMajorMatrix quad =
+            features.transpose() * _weights(group_count).transpose();
+        Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+            temp = quad.cast<float>();
+        temp.array() += 1.f;
+        vector_log(temp.size(), temp.data());
+
+        const float * __restrict__ score = VectorFloat_data(score_);
+        const float * __restrict__ log_coeff = VectorFloat_data(log_coeff_);
+        for (size_t v = 0; v < value_count; ++v) {
+            float * __restrict__ accum =
+                scores_accum.data() + v * group_count;
+            const float * __restrict__ row = temp.data() + v * group_count;
+            for (size_t i = 0; i < group_count; ++i) {
+                accum[i] += score[i] + log_coeff[i] * row[i];
+            }
+        }
+    }
+
+    void validate(
+            const Shared &,
+            const std::vector<Group> & groups) const {
+        DIST_ASSERT_EQ(score_.size(), groups.size());
+        DIST_ASSERT_EQ(log_coeff_.size(), groups.size());
+        DIST_ASSERT_EQ(log_det_.size(), groups.size());
+        DIST_ASSERT_EQ(update_count_.size(), groups.size());
+        DIST_ASSERT_EQ(psi_inv_.size(), groups.size());
+        DIST_ASSERT_EQ(weights_.size(), groups.size() * feature_count_);
+    }
+
+    void reserve(size_t capacity) {
+        score_.reserve(capacity);
+        log_coeff_.reserve(capacity);
+        log_det_.reserve(capacity);
+        update_count_.reserve(capacity);
+        psi_inv_.reserve(capacity);
+        weights_.reserve(capacity * feature_count_);
+    }
+
+    size_t memory_usage() const {
+        return sizeof(*this)
+             + heap_bytes(score_)
+             + heap_bytes(log_coeff_)
+             + heap_bytes(log_det_)
+             + heap_bytes(update_count_)
+             + heap_bytes(psi_inv_)
+             + heap_bytes(weights_);
+    }
+
+  private:
+    static size_t _feature_count(size_t dim) {
+        return dim * (dim + 1) / 2 + dim + 1;
+    }
+
+    ConstWeightsMap _weights(size_t group_count) const {
+        return ConstWeightsMap(weights_.data(), group_count, feature_count_);
+    }
+
+    static VectorD _post_mu(const Shared & shared, const Group & group) {
+        return (shared.kappa * shared.mu.template cast<double>()
+                + group.sum_x.template cast<double>())
+            / (shared.kappa + group.count);
+    }
+
+    Eigen::VectorXd _features(
+            const Shared & shared,
+            const Value & value) const {
+        const size_t dim = shared.dim();
+        const VectorD y = (value - shared.mu).template cast<double>();
+        Eigen::VectorXd features(feature_count_);
+        size_t pos = 0;
+        for (size_t i = 0; i < dim; ++i) {
+            for (size_t j = i; j < dim; ++j) {
+                features(pos++) = y(i) * y(j);
+            }
+        }
+        for (size_t i = 0; i < dim; ++i) {
+            features(pos++) = y(i);
+        }
+        features(pos) = 1;
+        return features;
+    }
+
+    void _refactor(size_t groupid, const Eigen::LLT<Matrix> & llt) {
+        const size_t dim = llt.matrixLLT().rows();
+        const MatrixD L =
+            llt.matrixL().toDenseMatrix().template cast<double>();
+        const MatrixD L_inv = L.template triangularView<Eigen::Lower>()
+            .solve(MatrixD::Identity(dim, dim));
+        psi_inv_[groupid].noalias() = L_inv.transpose() * L_inv;
+        log_det_[groupid] = log_det_from_llt(llt);
+        update_count_[groupid] = 0;
+    }
+
+    // psi += coeff diff diff^T
+    void _rank_one_update(
+            const Shared & shared,
+            size_t groupid,
+            const Group & group,
+            const VectorD & diff,
+            double coeff,
+            rng_t & rng) {
+        MatrixD & psi_inv = psi_inv_[groupid];
+        const VectorD u = psi_inv * diff;
+        const double denom = 1 + coeff * diff.dot(u);
+        if (DIST_UNLIKELY(++update_count_[groupid] >= refresh_period) or
+                DIST_UNLIKELY(not (denom > 1e-3))) {
+            update_group(shared, groupid, group, rng);
+        } else {
+            psi_inv.noalias() -= (coeff / denom) * (u * u.transpose());
+            log_det_[groupid] += std::log(denom);
+            _update_weights(shared, groupid, group);
+        }
+    }
+
+    void _update_weights(
+            const Shared & shared,
+            size_t groupid,
+            const Group & group) {
+        const size_t dim = shared.dim();
+        const float d = dim;
+        const float post_kappa = shared.kappa + group.count;
+        const float dof = shared.nu + group.count - d + 1.f;
+
+        // sigma = psi (kappa + 1) / (kappa dof)
+        const float sigma_scale = (post_kappa + 1.f) / (post_kappa * dof);
+        const float log_pi = 1.1447298858494002;
+        const float log_det_sigma =
+            log_det_[groupid] + d * fast_log(sigma_scale);
+        score_[groupid] =
+            fast_lgamma(0.5f * (dof + d)) - fast_lgamma(0.5f * dof)
+            - 0.5f * log_det_sigma
+            - 0.5f * d * (fast_log(dof) + log_pi);
+        log_coeff_[groupid] = -0.5f * (dof + d);
+
+        // weights of (y - m)^T P (y - m), with P = psi_inv / (sigma dof)
+        const MatrixD P =
+            psi_inv_[groupid] / (double(sigma_scale) * double(dof));
+        const VectorD m =
+            _post_mu(shared, group) - shared.mu.template cast<double>();
+        const VectorD Pm = P * m;
+        double * weights = weights_.data() + groupid * feature_count_;
+        size_t pos = 0;
+        for (size_t i = 0; i < dim; ++i) {
+            weights[pos++] = P(i, i);
+            for (size_t j = i + 1; j < dim; ++j) {
+                weights[pos++] = P(i, j) + P(j, i);
+            }
+        }
+        for (size_t i = 0; i < dim; ++i) {
+            weights[pos++] = -2 * Pm(i);
+        }
+        weights[pos] = m.dot(Pm);
+    }
+
+    size_t feature_count_;
+    VectorFloat score_;
+    VectorFloat log_coeff_;
+    Packed_<double> log_det_;
+    Packed_<uint32_t> update_count_;
+    Matrices psi_inv_;
+    Weights weights_;
 };
 };  // struct NormalInverseWishart
 
 extern template struct NormalInverseWishart<-1>;
 extern template struct NormalInverseWishart<2>;
 extern template struct NormalInverseWishart<3>;
+extern template struct NormalInverseWishart<4>;
+extern template struct NormalInverseWishart<8>;
+extern template struct NormalInverseWishart<16>;
 
 }  // namespace distributions
@@ -0,0 +1,293 @@
+// Copyright (c) 2014, Salesforce.com, Inc.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+// - Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// - Neither the name of Salesforce.com nor the names of its contributors
+//   may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+// COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+// OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+// TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <pthread.h>
+#include <cstddef>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <new>
+#include <distributions/common.hpp>
+#include <distributions/aligned_allocator.hpp>
+
+// VectorFloat, Sparse_ and SparseCounter allocate from a MemoryPool
+// when DIST_POOL_ALLOCATOR is nonzero.
+#ifndef DIST_POOL_ALLOCATOR
+#  define DIST_POOL_ALLOCATOR 0
+#endif  // DIST_POOL_ALLOCATOR
+
+namespace distributions {
+
+// --------------------------------------------------------------------------
+// Memory Pool
+//
+// This recycles aligned blocks through per-size-class free lists, so that
+// group churn in a mixture reuses the score vectors and hash nodes that
+// were freed by earlier remove_group calls, rather than returning to malloc.
+// Blocks are rounded up to powers of two between min_block_bytes and
+// max_block_bytes; larger requests bypass the pool.  Each thread owns one
+// pool, which is trimmed when the thread exits.  Blocks may be freed by a
+// different thread than allocated them, and then join that thread's pool.
+
+class MemoryPool {
+  public:
+    enum {
+        min_block_bytes = 32,
+        max_block_bytes = 1 << 16,
+        class_count = 12,
+        alignment = default_alignment
+    };
+
+    // free blocks above this many bytes are returned to malloc
+    static const size_t max_free_bytes = 1UL << 26;
+
+    static MemoryPool & thread_local_pool() {
+        MemoryPool *& pool = _thread_local_pointer();
+        if (DIST_UNLIKELY(pool == nullptr)) {
+            pool = new MemoryPool();
+            pthread_setspecific(_thread_key(), pool);
+        }
+        return * pool;
+    }
+
+    void * allocate(size_t bytes) {
+        if (DIST_UNLIKELY(bytes > max_block_bytes)) {
+            return _malloc(bytes);
+        }
+        const size_t size_class = _size_class(bytes);
+        if (Block * block = free_[size_class]) {
+            free_[size_class] = block->next;
+            free_bytes_ -= _block_bytes(size_class);
+            return block;
+        }
+        return _malloc(_block_bytes(size_class));
+    }
+
+    void deallocate(void * data, size_t bytes) {
+        if (DIST_UNLIKELY(bytes > max_block_bytes)) {
+            free(data);
+            return;
+        }
+        const size_t size_class = _size_class(bytes);
+        const size_t block_bytes = _block_bytes(size_class);
+        if (DIST_UNLIKELY(free_bytes_ + block_bytes > max_free_bytes)) {
+            free(data);
+            return;
+        }
+        Block * block = static_cast<Block *>(data);
+        block->next = free_[size_class];
+        free_[size_class] = block;
+        free_bytes_ += block_bytes;
+    }
+
+    // ensures that count blocks of the given size can be allocated
+    // without calling malloc
+    void reserve(size_t bytes, size_t count) {
+        if (bytes > max_block_bytes) {
+            return;
+        }
+        const size_t size_class = _size_class(bytes);
+        const size_t block_bytes = _block_bytes(size_class);
+        size_t free_count = 0;
+        for (Block * block = free_[size_class]; block; block = block->next) {
+            if (++free_count >= count) {
+                return;
+            }
+        }
+        for (; free_count < count; ++free_count) {
+            Block * block = static_cast<Block *>(_malloc(block_bytes));
+            block->next = free_[size_class];
+            free_[size_class] = block;
+            free_bytes_ += block_bytes;
+        }
+    }
+
+    // returns all free blocks to malloc
+    void trim() {
+        for (size_t i = 0; i < class_count; ++i) {
+            while (Block * block = free_[i]) {
+                free_[i] = block->next;
+                free(block);
+            }
+        }
+        free_bytes_ = 0;
+    }
+
+    size_t free_bytes() const { return free_bytes_; }
+
+  private:
+    struct Block {
+        Block * next;
+    };
+
+    MemoryPool() : free_bytes_(0) {
+        for (size_t i = 0; i < class_count; ++i) {
+            free_[i] = nullptr;
+        }
+    }
+
+    ~MemoryPool() { trim(); }
+
+    static void * _malloc(size_t bytes) {
+        void * result = nullptr;
+        if (posix_memalign(& result, alignment, bytes)) {
+            throw std::bad_alloc();
+        }
+        return result;
+    }
+
+    static size_t _size_class(size_t bytes) {
+        if (bytes <= min_block_bytes) {
+            return 0;
+        }
+        const size_t bits = sizeof(unsigned long) * 8;  // NOLINT(*)
+        return bits - __builtin_clzl(bytes - 1) - 5;
+    }
+
+    static size_t _block_bytes(size_t size_class) {
+        return size_t(min_block_bytes) << size_class;
+    }
+
+    static MemoryPool *& _thread_local_pointer() {
+        static thread_local MemoryPool * pool = nullptr;
+        return pool;
+    }
+
+    // called at thread exit; blocks freed later by this thread's
+    // destructors go to a fresh pool, which is destroyed in turn
+    static void _destroy(void * pool) {
+        delete static_cast<MemoryPool *>(pool);
+        _thread_local_pointer() = nullptr;
+    }
+
+    static pthread_key_t _thread_key() {
+        static pthread_key_t key = _create_thread_key();
+        return key;
+    }
+
+    static pthread_key_t _create_thread_key() {
+        pthread_key_t key;
+        int error = pthread_key_create(& key, & MemoryPool::_destroy);
+        DIST_ASSERT(not error, "pthread_key_create failed: " << error);
+        return key;
+    }
+
+    Block * free_[class_count];
+    size_t free_bytes_;
+};
+
+// --------------------------------------------------------------------------
+// Pool Allocator
+//
+// A stateless allocator drawing from the calling thread's MemoryPool,
+// with the same alignment guarantee as aligned_allocator.
+
+template<class T>
+class pool_allocator {
+  public:
+    typedef T value_type;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    typedef T * pointer;
+    typedef const T * const_pointer;
+
+    typedef T & reference;
+    typedef const T & const_reference;
+
+    template <class U>
+    pool_allocator(const pool_allocator<U> &) throw() {}
+    pool_allocator(const pool_allocator &) throw() {}
+    pool_allocator() throw() {}
+    ~pool_allocator() throw() {}
+
+    template<class U>
+    struct rebind {
+        typedef pool_allocator<U> other;
+    };
+
+    pointer address(reference r) const {
+        return & r;
+    }
+
+    const_pointer address(const_reference r) const {
+        return & r;
+    }
+
+    pointer allocate(size_t n, const void * /* hint */ = 0) {
+        MemoryPool & pool = MemoryPool::thread_local_pool();
+        void * result = pool.allocate(n * sizeof(T));
+        if (DIST_DEBUG_LEVEL >= 3) {
+            DIST_ASSERT_ALIGNED(static_cast<pointer>(result));
+        }
+        return static_cast<pointer>(result);
+    }
+
+    void deallocate(pointer p, size_type n) {
+        MemoryPool::thread_local_pool().deallocate(p, n * sizeof(T));
+    }
+
+    void construct(pointer p, const T & val) {
+        new(p) T(val);
+    }
+
+    void destroy(pointer p) {
+        p->~T();
+    }
+
+    size_type max_size() const throw() {
+        return std::numeric_limits<size_t>::max() / sizeof(T);
+    }
+};
+
+template<class T1, class T2>
+inline bool operator== (
+        const pool_allocator<T1> &,
+        const pool_allocator<T2> &) throw() {
+    return true;
+}
+
+template<class T1, class T2>
+inline bool operator!= (
+        const pool_allocator<T1> &,
+        const pool_allocator<T2> &) throw() {
+    return false;
+}
+
+// default allocator for sparse maps, selected by DIST_POOL_ALLOCATOR
+template<class T>
+struct default_allocator {
+#if DIST_POOL_ALLOCATOR
+    typedef pool_allocator<T> type;
+#else  // DIST_POOL_ALLOCATOR
+    typedef std::allocator<T> type;
+#endif  // DIST_POOL_ALLOCATOR
+};
+
+}   // namespace distributions
@@ -156,7 +156,6 @@ inline float score_student_t(
     return p;
 }
 
-// XXX: not optimized for speed
 template <typename Vector, typename Matrix>
 inline float score_mv_student_t(
         const Vector & v,
@@ -167,19 +166,25 @@ inline float score_mv_student_t(
   const float term1 = fast_lgamma(nu / 2. + static_cast<float>(d) / 2.)
       - fast_lgamma(nu / 2.);
 
-  // XXX: use Cholesky decomposition to make this faster
-  const Matrix sigma_inv = sigma.inverse();
-  const float sigma_det = sigma.determinant();
+  // sigma = L L^T, so log|sigma| = 2 sum log L_ii
+  // and diff^T sigma^-1 diff = |L^-1 diff|^2
+  Eigen::LLT<Matrix> llt(sigma);
+  const Matrix L = llt.matrixL();
+  float log_sigma_det = 0;
+  for (unsigned i = 0; i < d; ++i) {
+    log_sigma_det += 2.f * fast_log(L(i, i));
+  }
 
   const float log_pi = 1.1447298858494002;
 
-  const float term2 = -0.5 * fast_log(sigma_det)
+  const float term2 = -0.5 * log_sigma_det
       - static_cast<float>(d) / 2. * (fast_log(nu) + log_pi);
 
   const Vector diff = v - mu;
+  const float quad = llt.matrixL().solve(diff).squaredNorm();
 
   const float term3 = -0.5 * (nu + static_cast<float>(d)) *
-      fast_log(1. + 1. / nu * (diff.dot(sigma_inv * diff)));
+      fast_log(1. + 1. / nu * quad);
 
   return term1 + term2 + term3;
 }
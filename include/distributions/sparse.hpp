@@ -27,16 +27,28 @@
 
 #pragma once
 
+#include <functional>
 #include <utility>
 #include <unordered_map>
 #include <distributions/common.hpp>
+#include <distributions/memory.hpp>
+#include <distributions/pool_allocator.hpp>
 #include <distributions/trivial_hash.hpp>
 
 namespace distributions {
 
-template<class Key, class Value>
+template<
+    class Key,
+    class Value,
+    class Alloc =
+        typename default_allocator<std::pair<const Key, Value>>::type>
 class Sparse_ {
-    typedef std::unordered_map<Key, Value, TrivialHash<Key>> map_t;
+    typedef std::unordered_map<
+        Key,
+        Value,
+        TrivialHash<Key>,
+        std::equal_to<Key>,
+        Alloc> map_t;
 
     map_t map_;
 
@@ -48,6 +60,7 @@ class Sparse_ {
 
     size_t size() const { return map_.size(); }
     void clear() { map_.clear(); }
+    void reserve(size_t size) { map_.reserve(size); }
 
     bool contains(const Key & key) const {
         return map_.find(key) != map_.end();
@@ -101,6 +114,8 @@ class Sparse_ {
 
     void unsafe_erase(iterator i) { map_.erase(i); }
 
+    size_t memory_usage() const { return sizeof(*this) + heap_bytes(map_); }
+
     iterator begin() { return map_.begin(); }
     iterator end() { return map_.end(); }
     const_iterator begin() const { return map_.begin(); }
@@ -108,9 +123,18 @@ class Sparse_ {
 };
 
 
-template<class Key, class Value>
+template<
+    class Key,
+    class Value,
+    class Alloc =
+        typename default_allocator<std::pair<const Key, Value>>::type>
 class SparseCounter {
-    typedef std::unordered_map<Key, Value, TrivialHash<Key>> map_t;
+    typedef std::unordered_map<
+        Key,
+        Value,
+        TrivialHash<Key>,
+        std::equal_to<Key>,
+        Alloc> map_t;
 
     map_t map_;
     Value total_;
@@ -125,6 +149,10 @@ class SparseCounter {
         total_ = 0;
     }
 
+    void reserve(size_t size) { map_.reserve(size); }
+
+    size_t memory_usage() const { return sizeof(*this) + heap_bytes(map_); }
+
     void init_count(key_t key, value_t value) {
         if (DIST_LIKELY(value)) {
             bool success = map_.insert(std::make_pair(key, value)).second;
@@ -160,7 +188,7 @@ class SparseCounter {
 
     value_t remove(const key_t & key) { return add(key, -1); }
 
-    void merge(const SparseCounter<key_t, value_t> & other) {
+    void merge(const SparseCounter & other) {
         for (auto & i : other.map_) {
             add(i.first, i.second);
         }
@@ -33,6 +33,7 @@
 #include <iostream>
 #include <limits>
 #include <distributions/common.hpp>
+#include <distributions/instrument.hpp>
 #include <distributions/vendor/fmath.hpp>
 
 #define M_PIf (3.14159265358979f)
@@ -119,6 +120,7 @@ inline float fast_lgamma(float y) {
     // see loggamma.py for the code used to generate the coefficient table
 
     if (DIST_UNLIKELY(y < 2.5f or 4294967295.0f <= y)) {
+        DIST_INSTRUMENT_COUNT(FAST_LGAMMA_FALLBACK);
         return lgammaf(y);
     }
 
@@ -244,6 +246,7 @@ inline float fast_lgamma_nu(float nu) {
     // see loggamma.py:lstudent for coeff gen
 
     if (DIST_UNLIKELY(nu < 0.0625f or 4294967295.0f <= nu)) {
+        DIST_INSTRUMENT_COUNT(FAST_LGAMMA_NU_FALLBACK);
         return lgammaf(nu * 0.5f + 0.5f) - lgammaf(nu * 0.5f);
     }
 
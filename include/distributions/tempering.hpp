@@ -0,0 +1,270 @@
+// Copyright (c) 2014, Salesforce.com, Inc.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+// - Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// - Neither the name of Salesforce.com nor the names of its contributors
+//   may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+// COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+// OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+// TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <distributions/common.hpp>
+#include <distributions/random.hpp>
+#include <distributions/vector.hpp>
+#include <distributions/vector_math.hpp>
+#include <distributions/clustering.hpp>
+#include <distributions/mixture.hpp>
+#include <distributions/thread_pool.hpp>
+
+namespace distributions {
+
+// ParallelTempering runs several Gibbs chains over one column of data,
+// each targeting the posterior with its likelihood raised to an inverse
+// temperature beta, and swaps states between neighboring temperatures so
+// that hot chains help the cold chain (beta = 1) escape local modes.
+//
+// Each chain owns a Model::Mixture, a clustering CachedMixture and its own
+// rng_t stream, so chains sweep concurrently without locks.  The data
+// column and Shared are held read-only by all chains, without copies.
+// Swap moves run serially between rounds, scoring each chain's data by
+// Mixture::score_data.  Runs are deterministic given the seed, however
+// chains are scheduled.
+template<class Model, class ClusteringModel = Clustering<int>::PitmanYor>
+class ParallelTempering {
+  public:
+    typedef typename Model::Value Value;
+    typedef typename Model::Shared Shared;
+    typedef typename Model::Mixture Mixture;
+    typedef typename ClusteringModel::Mixture ClusteringMixture;
+    typedef std::vector<Value> Column;
+
+    class Chain {
+      public:
+        const ClusteringMixture & clustering_mixture() const {
+            return clustering_mixture_;
+        }
+        const Mixture & mixture() const { return mixture_; }
+
+        // packed groupids of each row
+        std::vector<size_t> assignments() const {
+            std::vector<size_t> groupids;
+            groupids.reserve(assignments_.size());
+            for (auto global : assignments_) {
+                groupids.push_back(ids_.global_to_packed(global));
+            }
+            return groupids;
+        }
+
+      private:
+        friend class ParallelTempering;
+
+        rng_t rng_;
+        ClusteringMixture clustering_mixture_;
+        Mixture mixture_;
+        MixtureIdTracker ids_;
+        std::vector<MixtureIdTracker::Id> assignments_;
+        VectorFloat scores_;
+        VectorFloat data_scores_;
+        float score_data_;
+    };
+
+    // betas are inverse temperatures, starting with the cold chain;
+    // the data column is shared by all chains
+    ParallelTempering(
+            const ClusteringModel & clustering,
+            const Shared & shared,
+            std::shared_ptr<const Column> column,
+            const std::vector<float> & betas,
+            rng_t::result_type seed) :
+        clustering_(clustering),
+        shared_(shared),
+        column_(column),
+        betas_(betas),
+        swap_attempts_(betas.size(), 0),
+        swap_accepts_(betas.size(), 0),
+        round_count_(0)
+    {
+        DIST_ASSERT(not betas.empty(), "expected at least one chain");
+        DIST_ASSERT(column, "missing data column");
+        rng_t rng(seed);
+        swap_rng_.seed(rng());
+        for (size_t i = 0; i < betas.size(); ++i) {
+            DIST_ASSERT(betas[i] > 0, "bad beta: " << betas[i]);
+            chains_.emplace_back(new Chain());
+            _init(*chains_.back(), rng());
+        }
+    }
+
+    size_t chain_count() const { return chains_.size(); }
+    size_t round_count() const { return round_count_; }
+    float beta(size_t rank) const { return betas_[rank]; }
+
+    // chains are ranked by temperature: chain(0) is the cold chain
+    const Chain & chain(size_t rank) const { return *chains_[rank]; }
+
+    // fraction of swaps accepted between ranks rank and rank + 1
+    float swap_acceptance(size_t rank) const {
+        return swap_attempts_[rank]
+            ? float(swap_accepts_[rank]) / swap_attempts_[rank]
+            : 0.f;
+    }
+
+    // Each round runs sweep_count Gibbs sweeps on every chain, spreading
+    // chains over up to thread_count threads of the global ThreadPool,
+    // then attempts swaps between neighboring temperatures.
+    void run(
+            size_t round_count,
+            size_t sweep_count = 1,
+            size_t thread_count = ThreadPool::cpu_count()) {
+        for (size_t round = 0; round < round_count; ++round) {
+            _sweep_chains(sweep_count, thread_count);
+            _swap_chains();
+            ++round_count_;
+        }
+    }
+
+  private:
+    void _init(Chain & chain, rng_t::result_type seed) const {
+        const Column & column = *column_;
+        const size_t row_count = column.size();
+        chain.rng_.seed(seed);
+
+        // start from a partition sampled from the prior, plus an empty group
+        std::vector<int> groupids =
+            clustering_.sample_assignments(row_count, chain.rng_);
+        std::vector<int> counts = Clustering<int>::count_assignments(groupids);
+        const size_t group_count = counts.size() + 1;
+        counts.push_back(0);
+        chain.clustering_mixture_.counts() = counts;
+        chain.clustering_mixture_.init(clustering_);
+
+        Mixture & mixture = chain.mixture_;
+        mixture.groups().resize(group_count);
+        for (auto & group : mixture.groups()) {
+            group.init(shared_, chain.rng_);
+        }
+        for (size_t row = 0; row < row_count; ++row) {
+            mixture.groups(groupids[row]).add_value(
+                shared_,
+                column[row],
+                chain.rng_);
+        }
+        mixture.init(shared_, chain.rng_);
+
+        chain.ids_.init(group_count);
+        chain.assignments_.resize(row_count);
+        for (size_t row = 0; row < row_count; ++row) {
+            chain.assignments_[row] =
+                chain.ids_.packed_to_global(groupids[row]);
+        }
+        chain.score_data_ = mixture.score_data(shared_, chain.rng_);
+    }
+
+    void _sweep(Chain & chain, float beta) const {
+        const Column & column = *column_;
+        rng_t & rng = chain.rng_;
+        ClusteringMixture & clustering_mixture = chain.clustering_mixture_;
+        Mixture & mixture = chain.mixture_;
+        MixtureIdTracker & ids = chain.ids_;
+        VectorFloat & scores = chain.scores_;
+        VectorFloat & data_scores = chain.data_scores_;
+
+        for (size_t row = 0, size = column.size(); row < size; ++row) {
+            const Value & value = column[row];
+            size_t groupid = ids.global_to_packed(chain.assignments_[row]);
+            mixture.remove_value(shared_, groupid, value, rng);
+            if (clustering_mixture.remove_value(clustering_, groupid)) {
+                ids.remove_group(groupid);
+                mixture.remove_group(shared_, groupid);
+            }
+
+            const size_t group_count = clustering_mixture.counts().size();
+            scores.resize(group_count);
+            clustering_mixture.score_value_unnormalized(clustering_, scores);
+            if (beta == 1) {
+                mixture.score_value(shared_, value, scores, rng);
+            } else {
+                data_scores.resize(group_count);
+                std::fill(data_scores.begin(), data_scores.end(), 0);
+                mixture.score_value(shared_, value, data_scores, rng);
+                vector_scale(group_count, data_scores.data(), beta);
+                vector_add(group_count, scores.data(), data_scores.data());
+            }
+            groupid = sample_from_scores_overwrite(rng, scores);
+
+            if (clustering_mixture.add_value(clustering_, groupid)) {
+                ids.add_group();
+                mixture.add_group(shared_, rng);
+            }
+            mixture.add_value(shared_, groupid, value, rng);
+            chain.assignments_[row] = ids.packed_to_global(groupid);
+        }
+    }
+
+    void _sweep_chains(size_t sweep_count, size_t thread_count) {
+        // chains are claimed one at a time, so that slow chains balance
+        ThreadPool::global().parallel_for(
+            chains_.size(),
+            thread_count,
+            [this, sweep_count](size_t rank) {
+                Chain & chain = *chains_[rank];
+                for (size_t sweep = 0; sweep < sweep_count; ++sweep) {
+                    _sweep(chain, betas_[rank]);
+                }
+                chain.score_data_ =
+                    chain.mixture_.score_data(shared_, chain.rng_);
+            });
+    }
+
+    // This alternates between swapping even and odd pairs of neighbors,
+    // accepting each swap with probability
+    // min(1, exp((beta[i] - beta[i+1]) * (score[i+1] - score[i]))).
+    void _swap_chains() {
+        for (size_t i = round_count_ % 2; i + 1 < chains_.size(); i += 2) {
+            const float score_diff =
+                chains_[i + 1]->score_data_ - chains_[i]->score_data_;
+            const float log_accept = (betas_[i] - betas_[i + 1]) * score_diff;
+            ++swap_attempts_[i];
+            if (log_accept >= 0 or
+                    sample_unif01(swap_rng_) < fast_exp(log_accept)) {
+                std::swap(chains_[i], chains_[i + 1]);
+                ++swap_accepts_[i];
+            }
+        }
+    }
+
+    const ClusteringModel clustering_;
+    const Shared shared_;
+    const std::shared_ptr<const Column> column_;
+    const std::vector<float> betas_;
+    std::vector<std::unique_ptr<Chain>> chains_;
+    std::vector<size_t> swap_attempts_;
+    std::vector<size_t> swap_accepts_;
+    size_t round_count_;
+    rng_t swap_rng_;
+};
+
+}   // namespace distributions
@@ -0,0 +1,103 @@
+// Copyright (c) 2014, Salesforce.com, Inc.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+// - Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// - Neither the name of Salesforce.com nor the names of its contributors
+//   may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+// COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+// OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+// TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <distributions/common.hpp>
+
+namespace distributions {
+
+// --------------------------------------------------------------------------
+// Thread Pool
+//
+// This runs batches of independent tasks on a set of persistent worker
+// threads, with the calling thread working alongside them.  Workers are
+// started on demand, up to the largest thread_count ever requested, and
+// live as long as the pool, so per-thread state such as the never-freed
+// thread_local scratch buffers in the models is allocated once per worker
+// rather than once per call.  Tasks are claimed dynamically, so results
+// should depend only on the task index, not on which thread ran it.
+//
+// Only one batch runs at a time.  A parallel_for called while another is
+// running, including from inside a task, runs serially on its caller.
+
+class ThreadPool {
+  public:
+    typedef std::function<void(size_t)> Task;
+
+    ThreadPool() {}
+    ~ThreadPool();
+
+    // the process-wide pool, whose workers live until exit
+    static ThreadPool & global();
+
+    static size_t cpu_count() {
+        static const size_t count =
+            std::max<size_t>(1, std::thread::hardware_concurrency());
+        return count;
+    }
+
+    size_t worker_count() const;
+
+    // calls task(i) for each i in [0, task_count), on up to thread_count
+    // threads counting the caller, and returns when all have finished
+    void parallel_for(
+            size_t task_count,
+            size_t thread_count,
+            const Task & task);
+
+  private:
+    ThreadPool(const ThreadPool &) = delete;
+    void operator=(const ThreadPool &) = delete;
+
+    void _work();
+    void _run_tasks();
+
+    std::atomic<bool> running_ {false};
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    std::vector<std::thread> workers_;
+    uint64_t batch_ = 0;
+    bool stopping_ = false;
+    const Task * task_ = nullptr;
+    size_t task_count_ = 0;
+    size_t open_slots_ = 0;
+    size_t busy_workers_ = 0;
+    std::atomic<size_t> next_task_ {0};
+};
+
+}   // namespace distributions
@@ -28,7 +28,12 @@
 # pragma once
 
 #include <distributions/common.hpp>
+#include <stdint.h>
 #include <sys/time.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#  include <x86intrin.h>
+#endif
 
 namespace distributions {
 
@@ -38,4 +43,21 @@ inline int64_t current_time_us() {
     return t.tv_usec + 1000000L * t.tv_sec;
 }
 
+inline int64_t current_time_ns() {
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_nsec + 1000000000L * t.tv_sec;
+}
+
+// A cheap monotonic tick counter for short intervals: the cpu timestamp
+// counter where available, else nanoseconds.  Tick rates vary by machine,
+// see instrument::Stats::ticks_per_sec.
+inline uint64_t current_ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return current_time_ns();
+#endif
+}
+
 }  // namespace distributions
@@ -30,6 +30,7 @@
 #include <memory>
 #include <vector>
 #include <distributions/aligned_allocator.hpp>
+#include <distributions/pool_allocator.hpp>
 
 // DEPRECATED, use DIST_ASSUME_ALIGNED directly
 #define VectorFloat_data(vf) (DIST_ASSUME_ALIGNED((vf).data()))
@@ -77,6 +78,14 @@ class Aligned_ {
         }
     }
 
+    Aligned_(Packed_<Value, pool_allocator<Value>> & source) :
+        data_(source.data()),
+        size_(source.size()) {
+        if (DIST_DEBUG_LEVEL >= 3) {
+            DIST_ASSERT_ALIGNED(data_);
+        }
+    }
+
     Value * data() { return data_; }
     size_t size() const { return size_; }
     Value & operator[] (size_t i) { return data_[i]; }
@@ -86,7 +95,20 @@ class Aligned_ {
     const size_t size_;
 };
 
+#if DIST_POOL_ALLOCATOR
+typedef Packed_<float, pool_allocator<float>> VectorFloat;
+#else  // DIST_POOL_ALLOCATOR
 typedef Packed_<float, aligned_allocator<float>> VectorFloat;
+#endif  // DIST_POOL_ALLOCATOR
 typedef Aligned_<float> AlignedFloats;
 
+// packed scores stored as Score, e.g. float, bfloat16_t or float16_t,
+// and allocated like VectorFloat
+template<class Score>
+struct ScoreVector {
+    typedef typename VectorFloat::allocator_type::template rebind<Score>::other
+        Alloc;
+    typedef Packed_<Score, Alloc> type;
+};
+
 }  // namespace distributions
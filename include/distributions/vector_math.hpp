@@ -27,6 +27,8 @@
 
 #pragma once
 
+#include <distributions/float16.hpp>
+
 namespace distributions {
 void vector_zero(
         const size_t size,
@@ -44,6 +46,10 @@ float vector_sum(
         const size_t size,
         const float * __restrict__ in);
 
+double vector_sum(
+        const size_t size,
+        const double * __restrict__ in);
+
 float vector_dot(
         const size_t size,
         const float * __restrict__ in1,
@@ -139,5 +145,40 @@ void vector_lgamma_nu(
         const size_t size,
         float * __restrict__ io);
 
+// Reduced-precision storage: inputs are widened to float before
+// arithmetic, and outputs are rounded on store.
+
+void vector_add(
+        const size_t size,
+        float * __restrict__ io,
+        const bfloat16_t * __restrict__ in);
+
+void vector_add(
+        const size_t size,
+        float * __restrict__ io,
+        const float16_t * __restrict__ in);
+
+void vector_add_subtract(
+        const size_t size,
+        float * __restrict__ io,
+        const bfloat16_t * __restrict__ in1,
+        const float * __restrict__ in2);
+
+void vector_add_subtract(
+        const size_t size,
+        float * __restrict__ io,
+        const float16_t * __restrict__ in1,
+        const float * __restrict__ in2);
+
+void vector_log(
+        const size_t size,
+        const float * __restrict__ in,
+        bfloat16_t * __restrict__ out);
+
+void vector_log(
+        const size_t size,
+        const float * __restrict__ in,
+        float16_t * __restrict__ out);
+
 }   // namespace distributions
 
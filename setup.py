@@ -100,6 +100,12 @@ else:
 
 use_protobuf = 'DISTRIBUTIONS_USE_PROTOBUF' in os.environ
 
+if 'DISTRIBUTIONS_INSTRUMENT' in os.environ:
+    extra_compile_args.append('-DDIST_INSTRUMENT=1')
+
+if 'DISTRIBUTIONS_POOL_ALLOCATOR' in os.environ:
+    extra_compile_args.append('-DDIST_POOL_ALLOCATOR=1')
+
 
 def make_extension(name):
     module = 'distributions.' + name
@@ -158,6 +164,7 @@ lp_extensions = make_extensions([
     'lp.models._niw',
     'lp.clustering',
     'lp.mixture',
+    'lp.instrument',
 ])
 
 
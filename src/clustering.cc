@@ -26,22 +26,37 @@
 // USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <algorithm>
+#include <cmath>
+#include <functional>
 #include <distributions/clustering.hpp>
 #include <distributions/special.hpp>
+#include <distributions/thread_pool.hpp>
+#include <distributions/vector_math.hpp>
 
 namespace distributions {
 
 // --------------------------------------------------------------------------
 // Assignments
 
+// Count group sizes in an assignment vector with the following properties:
+// 0 is the first group
+// there are no empty groups
+// the group IDs are contiguous.
+
+template<class count_t>
+static void validate_counts(const std::vector<count_t> & counts) {
+    if (DIST_DEBUG_LEVEL >= 2) {
+        if (not counts.empty()) {
+            count_t min_count =
+                * std::min_element(counts.begin(), counts.end());
+            DIST_ASSERT(min_count > 0, "groups are not contiguous");
+        }
+    }
+}
+
 template<class count_t>
 std::vector<count_t> Clustering<count_t>::count_assignments(
         const Assignments & assignments) {
-    // Count group sizes in an assignment vector with the following properties:
-    // 0 is the first group
-    // there are no empty groups
-    // the group IDs are contiguous.
-
     std::vector<count_t> counts;
     for (auto pair : assignments) {
         size_t gid = pair.second;
@@ -50,25 +65,210 @@ std::vector<count_t> Clustering<count_t>::count_assignments(
         }
         ++counts[gid];
     }
+    validate_counts(counts);
+    return counts;
+}
 
-    if (DIST_DEBUG_LEVEL >= 2) {
-        if (not counts.empty()) {
-            count_t min_count =
-                * std::min_element(counts.begin(), counts.end());
-            DIST_ASSERT(min_count > 0, "groups are not contiguous");
+template<class count_t>
+static void count_assignments_serial(
+        const count_t * begin,
+        const count_t * end,
+        std::vector<count_t> & counts) {
+    for (const count_t * pos = begin; pos != end; ++pos) {
+        size_t gid = *pos;
+        if (DIST_UNLIKELY(gid >= counts.size())) {
+            counts.resize(gid + 1, 0);
         }
+        ++counts[gid];
     }
+}
 
+template<class count_t>
+std::vector<count_t> Clustering<count_t>::count_assignments(
+        const count_t * assignments,
+        size_t size) {
+    // Each chunk is counted into a private histogram on the global thread
+    // pool, and the histograms are then summed.  Chunks are large enough
+    // that scheduling is negligible and small inputs stay on the calling
+    // thread.
+    const size_t min_chunk_size = 1UL << 20;
+    const size_t chunk_count =
+        std::min(size / min_chunk_size, ThreadPool::cpu_count());
+
+    std::vector<count_t> counts;
+    if (chunk_count <= 1) {
+        count_assignments_serial(assignments, assignments + size, counts);
+    } else {
+        std::vector<std::vector<count_t>> partial_counts(chunk_count);
+        ThreadPool::global().parallel_for(
+            chunk_count,
+            chunk_count,
+            [&](size_t chunk) {
+                count_assignments_serial(
+                    assignments + size * chunk / chunk_count,
+                    assignments + size * (chunk + 1) / chunk_count,
+                    partial_counts[chunk]);
+            });
+        for (const auto & partial : partial_counts) {
+            if (partial.size() > counts.size()) {
+                counts.resize(partial.size(), 0);
+            }
+            for (size_t gid = 0, end = partial.size(); gid < end; ++gid) {
+                counts[gid] += partial[gid];
+            }
+        }
+    }
+    validate_counts(counts);
     return counts;
 }
 
 
+// --------------------------------------------------------------------------
+// Count Histograms
+
+namespace {
+
+// This compresses a vector of counts into distinct nonzero counts and
+// their multiplicities, so that scores summing a function of each count
+// evaluate that function once per distinct count.
+template<class count_t>
+struct CountHistogram {
+    VectorFloat values;
+    VectorFloat weights;
+    VectorFloat temp;
+    size_t group_count;
+    size_t sample_size;
+
+    void init(const std::vector<count_t> & counts) {
+        values.clear();
+        weights.clear();
+        group_count = 0;
+        sample_size = 0;
+        count_t max_count = 0;
+        for (count_t count : counts) {
+            if (count) {
+                group_count += 1;
+                sample_size += count;
+                max_count = std::max(max_count, count);
+            }
+        }
+
+        // small counts are binned densely; large counts are rarely repeated
+        const count_t dense_size = std::min(
+            max_count + 1,
+            static_cast<count_t>(4 * counts.size() + 64));
+        dense_.assign(dense_size, 0);
+        for (count_t count : counts) {
+            if (DIST_LIKELY(count < dense_size)) {
+                ++dense_[count];
+            } else {
+                values.push_back(count);
+                weights.push_back(1);
+            }
+        }
+        for (count_t count = 1; count < dense_size; ++count) {
+            if (dense_[count]) {
+                values.push_back(count);
+                weights.push_back(dense_[count]);
+            }
+        }
+        temp.resize(values.size());
+    }
+
+    // sum over groups of lgamma(count - shift)
+    double sum_lgamma(float shift) {
+        const size_t size = values.size();
+        const float * __restrict__ in = VectorFloat_data(values);
+        const float * __restrict__ weight = VectorFloat_data(weights);
+        float * __restrict__ out = VectorFloat_data(temp);
+        for (size_t i = 0; i < size; ++i) {
+            out[i] = in[i] - shift;
+        }
+        vector_lgamma(size, out);
+        double result = 0;
+        for (size_t i = 0; i < size; ++i) {
+            result += weight[i] * out[i];
+        }
+        return result;
+    }
+
+    // sum over groups of count * log(count)
+    float sum_count_log_count() {
+        const size_t size = values.size();
+        const float * __restrict__ in = VectorFloat_data(values);
+        const float * __restrict__ weight = VectorFloat_data(weights);
+        float * __restrict__ out = VectorFloat_data(temp);
+        vector_log(size, in, out);
+        float result = 0;
+        for (size_t i = 0; i < size; ++i) {
+            result += weight[i] * in[i] * out[i];
+        }
+        return result;
+    }
+
+    static CountHistogram & get() {
+        static thread_local CountHistogram * histogram = nullptr;
+        if (DIST_UNLIKELY(not histogram)) {
+            histogram = new CountHistogram();  // never freed
+        }
+        return * histogram;
+    }
+
+  private:
+    std::vector<size_t> dense_;
+};
+
+// log(x (x + 1) ... (x + n - 1))
+inline double log_rising(double x, size_t n) {
+    return std::lgamma(x + n) - std::lgamma(x);
+}
+
+// log(x (x + step) ... (x + (n - 1) step))
+inline double log_rising_step(double x, double step, size_t n) {
+    if (step == 0) {
+        return n * std::log(x);
+    } else if (x < 1e6 * step) {
+        return n * std::log(step) + log_rising(x / step, n);
+    } else {
+        // avoid cancellation in lgamma of huge arguments
+        double result = 0;
+        for (size_t k = 0; k < n; ++k) {
+            result += std::log(x + k * step);
+        }
+        return result;
+    }
+}
+
+// The exchangeable partition probability function is
+//
+//   prod_{k < K} (alpha + k d) / rising(alpha, n)
+//     * prod_{groups} rising(1 - d, count - 1)
+//
+// where only the last factor depends on individual counts,
+// and is passed in as sum_lgamma = sum_{groups} lgamma(count - d).
+inline float pitman_yor_score_counts(
+        float alpha,
+        float d,
+        double sum_lgamma,
+        size_t group_count,
+        size_t sample_size) {
+    double score = sum_lgamma;
+    score -= group_count * static_cast<double>(fast_lgamma(1 - d));
+    score += log_rising_step(alpha, d, group_count);
+    score -= log_rising(alpha, sample_size);
+    return score;
+}
+
+}  // namespace
+
+
 // --------------------------------------------------------------------------
 // Pitman-Yor Model
 
 template<class count_t>
-std::vector<count_t> Clustering<count_t>::PitmanYor::sample_assignments(
+void Clustering<count_t>::PitmanYor::sample_assignments(
         count_t size,
+        count_t * assignments,
         rng_t & rng) const {
     // Note that we can ignore the constant shift of -log(size + alpha) in
     //
@@ -89,7 +289,6 @@ std::vector<count_t> Clustering<count_t>::PitmanYor::sample_assignments(
         static_cast<float>(size) + 1.f > static_cast<float>(size),
         "underflow expected");
 
-    std::vector<count_t> assignments(size);
     std::vector<float> likelihoods;
     likelihoods.reserve(100);  // just pick something safe
 
@@ -137,49 +336,158 @@ std::vector<count_t> Clustering<count_t>::PitmanYor::sample_assignments(
             likelihoods[assign] += 1.0f;
         }
     }
+}
 
-    return assignments;
+template<class count_t>
+std::vector<count_t> Clustering<count_t>::PitmanYor::sample_counts(
+        count_t size,
+        rng_t & rng) const {
+    // This uses the size-biased stick-breaking representation: the group
+    // containing the first remaining value has size 1 + Binomial(n - 1, W)
+    // with W ~ Beta(1 - d, alpha + d), and the remaining values are then
+    // distributed as a Pitman-Yor process with alpha' = alpha + d.
+
+    std::vector<count_t> counts;
+    count_t remaining = size;
+    for (count_t group_count = 1; remaining; ++group_count) {
+        const float w = sample_beta(rng, 1 - d, alpha + d * group_count);
+        std::binomial_distribution<count_t> sampler(remaining - 1, w);
+        const count_t count = 1 + sampler(rng);
+        counts.push_back(count);
+        remaining -= count;
+    }
+
+    return counts;
 }
 
-inline float fast_log_ratio(float numer, float denom) {
-    return fast_log(numer / denom);
+// This is the one-level Rao-Sandelius shuffle: scatter values into random
+// buckets small enough to fit in cache, then shuffle each bucket.
+// The bucket draws are replayed from a copy of rng to avoid storing them.
+// Buckets are shuffled in parallel on the global thread pool, each with
+// its own rng seeded from rng, so results do not depend on scheduling.
+template<class T>
+static void cache_friendly_shuffle(std::vector<T> & data, rng_t & rng) {
+    const size_t size = data.size();
+    const size_t bucket_size = 1UL << 16;
+    const size_t bucket_count = std::min(size / bucket_size, 1024UL);
+    if (bucket_count <= 1) {
+        std::shuffle(data.begin(), data.end(), rng);
+        return;
+    }
+
+    std::uniform_int_distribution<size_t> sample_bucket(0, bucket_count - 1);
+    std::vector<size_t> offsets(bucket_count + 1, 0);
+    rng_t replay = rng;
+    for (size_t i = 0; i < size; ++i) {
+        ++offsets[1 + sample_bucket(rng)];
+    }
+    for (size_t b = 0; b < bucket_count; ++b) {
+        offsets[b + 1] += offsets[b];
+    }
+
+    std::vector<T> shuffled(size);
+    std::vector<size_t> pos(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < size; ++i) {
+        shuffled[pos[sample_bucket(replay)]++] = data[i];
+    }
+    std::vector<rng_t::result_type> seeds(bucket_count);
+    for (auto & seed : seeds) {
+        seed = rng();
+    }
+    ThreadPool::global().parallel_for(
+        bucket_count,
+        ThreadPool::cpu_count(),
+        [&](size_t b) {
+            rng_t bucket_rng(seeds[b]);
+            std::shuffle(
+                shuffled.begin() + offsets[b],
+                shuffled.begin() + offsets[b + 1],
+                bucket_rng);
+        });
+    data.swap(shuffled);
 }
 
-inline float fast_lgamma_ratio(float start, size_t count) {
-    return fast_lgamma(start + count) - fast_lgamma(start);
+template<class count_t>
+std::vector<count_t> Clustering<count_t>::PitmanYor::sample_assignments_fast(
+        count_t size,
+        rng_t & rng) const {
+    // By exchangeability, a partition conditioned on its group sizes is
+    // uniformly distributed, so we can shuffle a canonical assignment and
+    // relabel groups in order of first appearance.
+
+    const std::vector<count_t> counts = sample_counts(size, rng);
+    const count_t group_count = counts.size();
+
+    std::vector<count_t> assignments(size);
+    auto pos = assignments.begin();
+    for (count_t groupid = 0; groupid < group_count; ++groupid) {
+        std::fill(pos, pos + counts[groupid], groupid);
+        pos += counts[groupid];
+    }
+    cache_friendly_shuffle(assignments, rng);
+
+    const count_t unseen = group_count;
+    std::vector<count_t> relabel(group_count, unseen);
+    count_t next_groupid = 0;
+    for (auto & groupid : assignments) {
+        count_t & label = relabel[groupid];
+        if (DIST_UNLIKELY(label == unseen)) {
+            label = next_groupid++;
+        }
+        groupid = label;
+    }
+
+    return assignments;
 }
 
 template<class count_t>
 float Clustering<count_t>::PitmanYor::score_counts(
         const std::vector<count_t> & counts) const {
-    double score = 0.0;
-    size_t sample_size = 0;
-    size_t nonempty_group_count = 0;
-
-    for (size_t count : counts) {
-        if (count) {
-            if (count == 1) {
-                score += fast_log_ratio(
-                    alpha + d * nonempty_group_count,
-                    alpha + sample_size);
-
-            } else if (count == 2) {
-                score += fast_log_ratio(
-                    (alpha + d * nonempty_group_count) * (1 - d),
-                    (alpha + sample_size) * (alpha + sample_size + 1));
-
-            } else {
-                score += fast_log(alpha + d * nonempty_group_count);
-                score += fast_lgamma_ratio(1 - d, count - 1);
-                score -= fast_lgamma_ratio(alpha + sample_size, count);
-            }
+    CountHistogram<count_t> & histogram = CountHistogram<count_t>::get();
+    histogram.init(counts);
+    return pitman_yor_score_counts(
+        alpha,
+        d,
+        histogram.sum_lgamma(d),
+        histogram.group_count,
+        histogram.sample_size);
+}
 
-            nonempty_group_count += 1;
-            sample_size += count;
+template<class count_t>
+void Clustering<count_t>::PitmanYor::score_counts_grid(
+        const std::vector<PitmanYor> & models,
+        const std::vector<count_t> & counts,
+        AlignedFloats scores_out) {
+    DIST_ASSERT_EQ(models.size(), scores_out.size());
+
+    // Grids typically share each d among many alphas, and only the
+    // per-count lgamma terms depend on d, so those are computed once
+    // per distinct d over the compressed counts.
+    CountHistogram<count_t> & histogram = CountHistogram<count_t>::get();
+    histogram.init(counts);
+
+    const size_t size = models.size();
+    std::vector<size_t> order(size);
+    for (size_t i = 0; i < size; ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+        return models[lhs].d < models[rhs].d;
+    });
+
+    double sum_lgamma = 0;
+    for (size_t pos = 0; pos < size; ++pos) {
+        const PitmanYor & model = models[order[pos]];
+        if (pos == 0 or model.d != models[order[pos - 1]].d) {
+            sum_lgamma = histogram.sum_lgamma(model.d);
         }
+        scores_out[order[pos]] = pitman_yor_score_counts(
+            model.alpha,
+            model.d,
+            sum_lgamma,
+            histogram.group_count,
+            histogram.sample_size);
     }
-
-    return score;
 }
 
 // --------------------------------------------------------------------------
@@ -228,19 +536,43 @@ inline float Clustering<count_t>::LowEntropy::_approximate_dataprob_correction(
 template<class count_t>
 float Clustering<count_t>::LowEntropy::score_counts(
         const std::vector<count_t> & counts) const {
-    float score = 0.0;
-    count_t sample_size = 0;
-    for (count_t count : counts) {
-        sample_size += count;
-        if (count > 1) {
-            score += count * fast_log(count);
-        }
+    CountHistogram<count_t> & histogram = CountHistogram<count_t>::get();
+    histogram.init(counts);
+    return _score_counts(
+        histogram.sum_count_log_count(),
+        histogram.sample_size,
+        counts.size());
+}
+
+template<class count_t>
+void Clustering<count_t>::LowEntropy::score_counts_grid(
+        const std::vector<LowEntropy> & models,
+        const std::vector<count_t> & counts,
+        AlignedFloats scores_out) {
+    DIST_ASSERT_EQ(models.size(), scores_out.size());
+
+    // only the corrections depend on dataset_size
+    CountHistogram<count_t> & histogram = CountHistogram<count_t>::get();
+    histogram.init(counts);
+    const float sum_count_log_count = histogram.sum_count_log_count();
+    for (size_t i = 0, size = models.size(); i < size; ++i) {
+        scores_out[i] = models[i]._score_counts(
+            sum_count_log_count,
+            histogram.sample_size,
+            counts.size());
     }
-    DIST_ASSERT_LE(sample_size, dataset_size);
+}
 
+template<class count_t>
+float Clustering<count_t>::LowEntropy::_score_counts(
+        float sum_count_log_count,
+        count_t sample_size,
+        size_t group_count) const {
+    DIST_ASSERT_LE(sample_size, dataset_size);
+    float score = sum_count_log_count;
     if (sample_size != dataset_size) {
         float log_factor = _approximate_postpred_correction(sample_size);
-        score += log_factor * (counts.size() - 1);
+        score += log_factor * (group_count - 1);
         score += _approximate_dataprob_correction(sample_size);
     }
     score -= log_partition_function(sample_size);
@@ -248,12 +580,12 @@ float Clustering<count_t>::LowEntropy::score_counts(
 }
 
 template<class count_t>
-std::vector<count_t> Clustering<count_t>::LowEntropy::sample_assignments(
+void Clustering<count_t>::LowEntropy::sample_assignments(
         count_t sample_size,
+        count_t * assignments,
         rng_t & rng) const {
     DIST_ASSERT_LE(sample_size, dataset_size);
 
-    std::vector<count_t> assignments(sample_size);
     std::vector<count_t> counts;
     std::vector<float> likelihoods;
     counts.reserve(100);
@@ -261,7 +593,8 @@ std::vector<count_t> Clustering<count_t>::LowEntropy::sample_assignments(
     const count_t bogus = 0;
     count_t size = 0;
 
-    for (count_t & assign : assignments) {
+    for (count_t i = 0; i < sample_size; ++i) {
+        count_t & assign = assignments[i];
         float likelihood_empty = fast_exp(score_add_value(0, bogus, size));
         if (DIST_UNLIKELY(counts.empty()) or counts.back()) {
             counts.push_back(0);
@@ -278,8 +611,6 @@ std::vector<count_t> Clustering<count_t>::LowEntropy::sample_assignments(
         float new_likelihood = fast_exp(score_add_value(count, bogus, bogus));
         likelihood = new_likelihood;
     }
-
-    return assignments;
 }
 
 
@@ -0,0 +1,148 @@
+// Copyright (c) 2014, Salesforce.com, Inc.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+// - Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// - Neither the name of Salesforce.com nor the names of its contributors
+//   may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+// COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+// OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+// TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <string.h>
+#include <mutex>
+#include <vector>
+#include <distributions/instrument.hpp>
+
+namespace distributions {
+namespace instrument {
+
+const char * counter_name(Counter counter) {
+    static const char * names[] = {
+#define DIST_INSTRUMENT_NAME(name) #name,
+        DIST_INSTRUMENT_COUNTERS(DIST_INSTRUMENT_NAME)
+#undef DIST_INSTRUMENT_NAME
+    };
+    DIST_ASSERT_LT(counter, COUNTER_COUNT);
+    return names[counter];
+}
+
+const char * timer_name(Timer timer) {
+    static const char * names[] = {
+#define DIST_INSTRUMENT_NAME(name) #name,
+        DIST_INSTRUMENT_TIMERS(DIST_INSTRUMENT_NAME)
+#undef DIST_INSTRUMENT_NAME
+    };
+    DIST_ASSERT_LT(timer, TIMER_COUNT);
+    return names[timer];
+}
+
+namespace {
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<ThreadStats *> stats;
+
+    static Registry & get() {
+        // leaked, so that thread stats stay valid during static destruction
+        static Registry * registry = new Registry();
+        return * registry;
+    }
+};
+
+void clear(std::atomic<uint64_t> & value) {
+    value.store(0, std::memory_order_relaxed);
+}
+
+uint64_t load(const std::atomic<uint64_t> & value) {
+    return value.load(std::memory_order_relaxed);
+}
+
+double measure_ticks_per_sec() {
+    const int64_t start_us = current_time_us();
+    const uint64_t start_ticks = current_ticks();
+    int64_t elapsed_us;
+    do {
+        elapsed_us = current_time_us() - start_us;
+    } while (elapsed_us < 2000);
+    const uint64_t elapsed_ticks = current_ticks() - start_ticks;
+    return elapsed_ticks / (elapsed_us * 1e-6);
+}
+
+}  // namespace
+
+ThreadStats & create_thread_stats() {
+    ThreadStats * stats = new ThreadStats();
+    for (auto & value : stats->counts) { clear(value); }
+    for (auto & value : stats->timer_counts) { clear(value); }
+    for (auto & value : stats->timer_ticks) { clear(value); }
+    for (auto & histogram : stats->timer_histograms) {
+        for (auto & value : histogram) { clear(value); }
+    }
+
+    Registry & registry = Registry::get();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.stats.push_back(stats);
+    return * stats;
+}
+
+Stats snapshot() {
+    static const double ticks_per_sec = measure_ticks_per_sec();
+
+    Registry & registry = Registry::get();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    // code compiled with DIST_INSTRUMENT may call into a library
+    // compiled without it, and vice versa
+    Stats result;
+    memset(& result, 0, sizeof(result));
+    result.enabled = enabled() or not registry.stats.empty();
+    result.ticks_per_sec = ticks_per_sec;
+    for (const ThreadStats * stats : registry.stats) {
+        for (size_t c = 0; c < COUNTER_COUNT; ++c) {
+            result.counts[c] += load(stats->counts[c]);
+        }
+        for (size_t t = 0; t < TIMER_COUNT; ++t) {
+            TimerStats & timer = result.timers[t];
+            timer.count += load(stats->timer_counts[t]);
+            timer.ticks += load(stats->timer_ticks[t]);
+            for (size_t i = 0; i < HISTOGRAM_SIZE; ++i) {
+                timer.histogram[i] += load(stats->timer_histograms[t][i]);
+            }
+        }
+    }
+    return result;
+}
+
+// Only threads that are not concurrently instrumented are reset exactly.
+void reset() {
+    Registry & registry = Registry::get();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (ThreadStats * stats : registry.stats) {
+        for (auto & value : stats->counts) { clear(value); }
+        for (auto & value : stats->timer_counts) { clear(value); }
+        for (auto & value : stats->timer_ticks) { clear(value); }
+        for (auto & histogram : stats->timer_histograms) {
+            for (auto & value : histogram) { clear(value); }
+        }
+    }
+}
+
+}  // namespace instrument
+}  // namespace distributions
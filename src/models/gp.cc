@@ -25,6 +25,7 @@
 // TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
 // USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#include <algorithm>
 #include <distributions/models/gp.hpp>
 #include <distributions/vector_math.hpp>
 
@@ -37,6 +38,12 @@ void GammaPoisson::MixtureValueScorer::score_value(
         rng_t &) const {
     const size_t size = scores_accum.size();
 
+    const float * row = table_.row(value);
+    if (DIST_LIKELY(row)) {
+        vector_add(size, VectorFloat_data(scores_accum), row);
+        return;
+    }
+
     static thread_local VectorFloat * temp_ = nullptr;
     if (DIST_UNLIKELY(not temp_)) {
         temp_ = new VectorFloat(size);  // never freed
@@ -66,4 +73,57 @@ void GammaPoisson::MixtureValueScorer::score_value(
     }
 }
 
+void GammaPoisson::MixtureValueScorer::score_values(
+        const Shared &,
+        const std::vector<Group> &,
+        const std::vector<Value> & values,
+        AlignedFloats scores_accum,
+        rng_t &) const {
+    const size_t group_count = score_.size();
+    const size_t value_count = values.size();
+    DIST_ASSERT_EQ(scores_accum.size(), value_count * group_count);
+
+    // Scores are computed in tiles of value_block values x group_block
+    // groups, so that each tile's score, post_alpha, score_coeff stay
+    // in L1 cache while being reused by every value in the tile, and
+    // each tile writes to only a few rows of scores_accum.
+    const size_t value_block = 64;
+    const size_t group_block = 256;
+
+    static thread_local VectorFloat * temp_ = nullptr;
+    if (DIST_UNLIKELY(not temp_)) {
+        temp_ = new VectorFloat(group_block);  // never freed
+    }
+    float * __restrict__ temp = VectorFloat_data(*temp_);
+
+    for (size_t v_begin = 0; v_begin < value_count; v_begin += value_block) {
+        const size_t v_end = std::min(v_begin + value_block, value_count);
+        for (size_t begin = 0; begin < group_count; begin += group_block) {
+            const size_t size = std::min(group_block, group_count - begin);
+            const float * __restrict__ score = score_.data() + begin;
+            const float * __restrict__ post_alpha =
+                post_alpha_.data() + begin;
+            const float * __restrict__ score_coeff =
+                score_coeff_.data() + begin;
+
+            for (size_t v = v_begin; v < v_end; ++v) {
+                const float value = values[v];
+                const float log_factorial_value =
+                    fast_log_factorial(values[v]);
+                float * __restrict__ scores_accum_noalias =
+                    scores_accum.data() + v * group_count + begin;
+                for (size_t i = 0; i < size; ++i) {
+                    temp[i] = fast_lgamma(post_alpha[i] + value);
+                }
+                for (size_t i = 0; i < size; ++i) {
+                    scores_accum_noalias[i] += score[i]
+                        + temp[i]
+                        - log_factorial_value
+                        + score_coeff[i] * value;
+                }
+            }
+        }
+    }
+}
+
 }   // namespace distributions
@@ -25,12 +25,14 @@
 // TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
 // USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#include <algorithm>
 #include <distributions/models/nich.hpp>
 #include <distributions/vector_math.hpp>
 
 namespace distributions {
 
-void NormalInverseChiSq::MixtureValueScorer::score_value(
+template<class Score>
+void NormalInverseChiSq::MixtureValueScorer_<Score>::score_value(
         const Shared &,
         const std::vector<Group> &,
         const Value & value,
@@ -47,13 +49,13 @@ void NormalInverseChiSq::MixtureValueScorer::score_value(
 
     const float value_noalias = value;
     float * __restrict__ scores_accum_noalias = VectorFloat_data(scores_accum);
-    const float * __restrict__ score =
+    const Score * __restrict__ score =
         VectorFloat_data(score_);
-    const float * __restrict__ log_coeff =
+    const Score * __restrict__ log_coeff =
         VectorFloat_data(log_coeff_);
-    const float * __restrict__ precision =
+    const Score * __restrict__ precision =
         VectorFloat_data(precision_);
-    const float * __restrict__ mean = VectorFloat_data(mean_);
+    const Score * __restrict__ mean = VectorFloat_data(mean_);
     float * __restrict__ temp = VectorFloat_data(*temp_);
 
     // Version 1
@@ -101,4 +103,58 @@ void NormalInverseChiSq::MixtureValueScorer::score_value(
 #endif
 }
 
+template<class Score>
+void NormalInverseChiSq::MixtureValueScorer_<Score>::score_values(
+        const Shared &,
+        const std::vector<Group> &,
+        const std::vector<Value> & values,
+        AlignedFloats scores_accum,
+        rng_t &) const {
+    const size_t group_count = score_.size();
+    const size_t value_count = values.size();
+    DIST_ASSERT_EQ(scores_accum.size(), value_count * group_count);
+
+    // Scores are computed in tiles of value_block values x group_block
+    // groups, so that each tile's score, log_coeff, precision, mean stay
+    // in L1 cache while being reused by every value in the tile, and
+    // each tile writes to only a few rows of scores_accum.
+    const size_t value_block = 64;
+    const size_t group_block = 256;
+
+    static thread_local VectorFloat * temp_ = nullptr;
+    if (DIST_UNLIKELY(not temp_)) {
+        temp_ = new VectorFloat(group_block);  // never freed
+    }
+    float * __restrict__ temp = VectorFloat_data(*temp_);
+
+    for (size_t v_begin = 0; v_begin < value_count; v_begin += value_block) {
+        const size_t v_end = std::min(v_begin + value_block, value_count);
+        for (size_t begin = 0; begin < group_count; begin += group_block) {
+            const size_t size = std::min(group_block, group_count - begin);
+            const Score * __restrict__ score = score_.data() + begin;
+            const Score * __restrict__ log_coeff = log_coeff_.data() + begin;
+            const Score * __restrict__ precision = precision_.data() + begin;
+            const Score * __restrict__ mean = mean_.data() + begin;
+
+            for (size_t v = v_begin; v < v_end; ++v) {
+                const float value = values[v];
+                float * __restrict__ scores_accum_noalias =
+                    scores_accum.data() + v * group_count + begin;
+                for (size_t i = 0; i < size; ++i) {
+                    temp[i] = 1.f + precision[i] * sqr(value - mean[i]);
+                }
+                vector_log(size, temp);
+                for (size_t i = 0; i < size; ++i) {
+                    scores_accum_noalias[i] +=
+                        score[i] + log_coeff[i] * temp[i];
+                }
+            }
+        }
+    }
+}
+
+template struct NormalInverseChiSq::MixtureValueScorer_<float>;
+template struct NormalInverseChiSq::MixtureValueScorer_<bfloat16_t>;
+template struct NormalInverseChiSq::MixtureValueScorer_<float16_t>;
+
 }   // namespace distributions
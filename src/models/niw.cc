@@ -32,5 +32,8 @@ namespace distributions {
 template struct NormalInverseWishart<-1>;
 template struct NormalInverseWishart<2>;
 template struct NormalInverseWishart<3>;
+template struct NormalInverseWishart<4>;
+template struct NormalInverseWishart<8>;
+template struct NormalInverseWishart<16>;
 
 }  // namespace distributions
@@ -27,6 +27,7 @@
 
 #include <distributions/random.hpp>
 #include <distributions/aligned_allocator.hpp>
+#include <distributions/pool_allocator.hpp>
 
 namespace distributions {
 
@@ -142,6 +143,7 @@ float score_from_scores_overwrite(
 
 INSTANTIATE_TEMPLATES(std::allocator<float>)
 INSTANTIATE_TEMPLATES(aligned_allocator<float>)
+INSTANTIATE_TEMPLATES(pool_allocator<float>)
 
 #undef INSTANTIATE_TEMPLATES
 
@@ -286,6 +286,7 @@ void get_log_stirling1_row(size_t n, std::vector<float, Alloc> & result) {
 
 INSTANTIATE_TEMPLATES(std::allocator<float>)
 INSTANTIATE_TEMPLATES(aligned_allocator<float>)
+INSTANTIATE_TEMPLATES(pool_allocator<float>)
 
 #undef INSTANTIATE_TEMPLATES
 
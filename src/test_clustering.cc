@@ -0,0 +1,237 @@
+// Copyright (c) 2014, Salesforce.com, Inc.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+// - Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// - Neither the name of Salesforce.com nor the names of its contributors
+//   may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+// COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+// OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+// TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <distributions/clustering.hpp>
+#include <distributions/mixture.hpp>
+#include <distributions/random.hpp>
+
+// This checks clustering paths that the python tests do not reach:
+// the bucketed shuffle behind PitmanYor::sample_assignments_fast, used
+// for sizes of at least 2^17, score_counts_grid, and LowEntropy's cached
+// mixture scores.
+
+using namespace distributions;  // NOLINT(*)
+
+typedef Clustering<int> Clust;
+
+rng_t rng;
+
+// Under a uniform shuffle, group g's share of each quarter of the
+// assignments is hypergeometric, and adjacent pairs fall in the same group
+// sum_g c_g (c_g - 1) / (n - 1) times in expectation.
+void check_shuffled(const std::vector<int> & assignments) {
+    const size_t size = assignments.size();
+    const std::vector<int> counts = Clust::count_assignments(assignments);
+
+    double expected_pairs = 0;
+    for (int count : counts) {
+        expected_pairs += double(count) * (count - 1) / (size - 1);
+    }
+    size_t pairs = 0;
+    for (size_t i = 1; i < size; ++i) {
+        pairs += (assignments[i] == assignments[i - 1]);
+    }
+    const double pair_tol = 6 * std::sqrt(expected_pairs) + 10;
+    DIST_ASSERT(std::fabs(pairs - expected_pairs) <= pair_tol,
+        "size " << size << " has " << pairs << " equal neighbors, expected "
+        << expected_pairs);
+
+    const size_t part_count = 4;
+    for (size_t part = 0; part < part_count; ++part) {
+        const size_t begin = size * part / part_count;
+        const size_t end = size * (part + 1) / part_count;
+        std::vector<int> part_counts(counts.size(), 0);
+        for (size_t i = begin; i < end; ++i) {
+            ++part_counts[assignments[i]];
+        }
+        const double fraction = double(end - begin) / size;
+        for (size_t g = 0; g < counts.size(); ++g) {
+            const double mean = counts[g] * fraction;
+            const double tol = 6 * std::sqrt(mean * (1 - fraction)) + 2;
+            DIST_ASSERT(std::fabs(part_counts[g] - mean) <= tol,
+                "size " << size << ", group " << g << " has " <<
+                part_counts[g] << " values in part " << part <<
+                ", expected " << mean);
+        }
+    }
+}
+
+void test_sample_assignments_fast() {
+    Clust::PitmanYor model;
+    model.alpha = 2.f;
+    model.d = 0.2f;
+    for (size_t size : {1 << 17, (1 << 18) + 12345, 1 << 21}) {
+        const auto assignments = model.sample_assignments_fast(size, rng);
+        DIST_ASSERT_EQ(assignments.size(), size);
+
+        // groups are labeled in order of first appearance
+        int next_groupid = 0;
+        for (int groupid : assignments) {
+            DIST_ASSERT_LE(groupid, next_groupid);
+            next_groupid = std::max(next_groupid, groupid + 1);
+        }
+        check_shuffled(assignments);
+    }
+}
+
+template<class count_t>
+std::vector<std::vector<count_t>> example_counts() {
+    std::vector<std::vector<count_t>> examples = {
+        {1},
+        {1, 1, 1, 1},
+        {5, 0, 3},
+        {100, 1, 20, 0, 0, 7},
+    };
+    std::vector<count_t> large;
+    for (size_t i = 0; i < 1000; ++i) {
+        large.push_back(sample_int(rng, 0, 50));
+    }
+    examples.push_back(large);
+    return examples;
+}
+
+void check_grid_score(float expected, float actual, size_t i) {
+    DIST_ASSERT(
+        std::fabs(actual - expected) <= 1e-5f * (1.f + std::fabs(expected)),
+        "grid point " << i << " scored " << actual << ", expected "
+        << expected);
+}
+
+template<class count_t>
+void test_pitman_yor_grid() {
+    typedef typename Clustering<count_t>::PitmanYor Model;
+
+    // visit repeated d values out of order
+    std::vector<Model> models;
+    for (float d : {0.5f, 0.f, 0.9f, 0.1f, 0.5f}) {
+        for (float alpha : {10.f, 0.1f, 1.f}) {
+            Model model;
+            model.alpha = alpha;
+            model.d = d;
+            models.push_back(model);
+        }
+    }
+
+    for (const auto & counts : example_counts<count_t>()) {
+        VectorFloat scores(models.size());
+        Model::score_counts_grid(models, counts, scores);
+        for (size_t i = 0; i < models.size(); ++i) {
+            check_grid_score(models[i].score_counts(counts), scores[i], i);
+        }
+    }
+}
+
+template<class count_t>
+void test_low_entropy_grid() {
+    typedef typename Clustering<count_t>::LowEntropy Model;
+
+    for (const auto & counts : example_counts<count_t>()) {
+        count_t sample_size = 0;
+        for (count_t count : counts) {
+            sample_size += count;
+        }
+        std::vector<Model> models;
+        for (count_t scale : {1, 2, 10}) {
+            for (count_t extra : {0, 1}) {
+                Model model;
+                model.dataset_size = sample_size * scale + extra;
+                models.push_back(model);
+            }
+        }
+
+        VectorFloat scores(models.size());
+        Model::score_counts_grid(models, counts, scores);
+        for (size_t i = 0; i < models.size(); ++i) {
+            check_grid_score(models[i].score_counts(counts), scores[i], i);
+        }
+    }
+}
+
+// CachedMixture should agree with the uncached MixtureDriver, which
+// scores each group by score_add_value, through adds and removes.
+void test_low_entropy_cached_mixture() {
+    typedef Clust::LowEntropy Model;
+    typedef Model::CachedMixture Cached;
+    typedef MixtureDriver<Model, int> Uncached;
+
+    Model model;
+    model.dataset_size = 1000;
+    Cached cached;
+    Uncached uncached;
+    cached.counts() = {3, 0, 1, 10};
+    uncached.counts() = cached.counts();
+    cached.init(model);
+    uncached.init(model);
+
+    VectorFloat expected;
+    VectorFloat actual;
+    VectorFloat actual_unnormalized;
+    for (size_t step = 0; step < 2000; ++step) {
+        const size_t group_count = cached.counts().size();
+        const size_t groupid = sample_int(rng, 0, group_count - 1);
+        const bool add = cached.sample_size() < 2 or
+            (cached.sample_size() < 500 and sample_bernoulli(rng, 0.5f));
+        if (add) {
+            const bool cached_added = cached.add_value(model, groupid);
+            const bool uncached_added = uncached.add_value(model, groupid);
+            DIST_ASSERT_EQ(cached_added, uncached_added);
+        } else if (cached.counts(groupid)) {
+            const bool cached_removed = cached.remove_value(model, groupid);
+            const bool uncached_removed =
+                uncached.remove_value(model, groupid);
+            DIST_ASSERT_EQ(cached_removed, uncached_removed);
+        }
+        DIST_ASSERT(cached.counts() == uncached.counts(), "counts differ");
+
+        const size_t size = cached.counts().size();
+        expected.resize(size);
+        actual.resize(size);
+        actual_unnormalized.resize(size);
+        uncached.score_value(model, expected);
+        cached.score_value(model, actual);
+        cached.score_value_unnormalized(model, actual_unnormalized);
+        for (size_t i = 0; i < size; ++i) {
+            const float tol = 1e-4f * (1.f + std::fabs(expected[i]));
+            DIST_ASSERT(std::fabs(actual[i] - expected[i]) <= tol,
+                "step " << step << ", group " << i << " scored " <<
+                actual[i] << ", expected " << expected[i]);
+            DIST_ASSERT_EQ(actual_unnormalized[i], actual[i]);
+        }
+    }
+}
+
+int main() {
+    test_sample_assignments_fast();
+    test_pitman_yor_grid<int>();
+    test_low_entropy_grid<int>();
+    test_low_entropy_cached_mixture();
+    return 0;
+}
@@ -3,6 +3,10 @@
 #include <distributions/clustering.hpp>
 #include <distributions/common.hpp>
 #include <distributions/cython.hpp>
+#include <distributions/float16.hpp>
+#include <distributions/instrument.hpp>
+#include <distributions/io/snapshot.hpp>
+#include <distributions/memory.hpp>
 #include <distributions/mixins.hpp>
 #include <distributions/mixture.hpp>
 #include <distributions/models/bb.hpp>
@@ -12,10 +16,13 @@
 #include <distributions/models/gp.hpp>
 #include <distributions/models/nich.hpp>
 #include <distributions/models/niw.hpp>
+#include <distributions/pool_allocator.hpp>
 #include <distributions/random_fwd.hpp>
 #include <distributions/random.hpp>
 #include <distributions/sparse.hpp>
 #include <distributions/special.hpp>
+#include <distributions/tempering.hpp>
+#include <distributions/thread_pool.hpp>
 #include <distributions/timers.hpp>
 #include <distributions/trivial_hash.hpp>
 #include <distributions/vector.hpp>
@@ -0,0 +1,317 @@
+// Copyright (c) 2014, Salesforce.com, Inc.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+// - Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// - Neither the name of Salesforce.com nor the names of its contributors
+//   may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+// COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+// OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+// TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+#include <distributions/random.hpp>
+#include <distributions/models/niw.hpp>
+
+// This checks the NIW caches against direct computation: each group's
+// incremental Cholesky factor against a fresh factorization of its
+// posterior scale, and the mixture's batched scores against each group's
+// own score_value.
+
+using namespace distributions;  // NOLINT(*)
+
+rng_t rng;
+
+template<class Model>
+typename Model::Shared example_shared(size_t dim) {
+    typename Model::Shared shared = Model::Shared::EXAMPLE();
+    shared.mu = Model::Vector::Zero(dim);
+    shared.psi = Model::Matrix::Identity(dim, dim);
+    shared.nu = dim + 1;
+    return shared;
+}
+
+template<class Model>
+typename Model::Value sample_near(size_t dim, float center) {
+    typename Model::Value value(dim);
+    for (size_t i = 0; i < dim; ++i) {
+        value(i) = center + sample_std_normal(rng);
+    }
+    return value;
+}
+
+void assert_close_score(float expected, float actual, const char * what) {
+    const float tol = 1e-3f * (1.f + std::fabs(expected));
+    DIST_ASSERT(std::fabs(actual - expected) <= tol,
+        what << ": expected " << expected << ", actual " << actual);
+}
+
+// A copy with its cache invalidated scores by factoring
+// shared.plus_group(group).psi from scratch.
+template<class Model>
+void assert_group_matches_fresh(
+        const typename Model::Shared & shared,
+        const typename Model::Group & group,
+        const typename Model::Value & value) {
+    typename Model::Group fresh = group;
+    fresh.invalidate_cache();
+    assert_close_score(
+        fresh.score_value(shared, value, rng),
+        group.score_value(shared, value, rng),
+        "score_value");
+    assert_close_score(
+        fresh.score_data(shared, rng),
+        group.score_data(shared, rng),
+        "score_data");
+
+    typename Model::Scorer scorer;
+    typename Model::Scorer fresh_scorer;
+    scorer.init(shared, group, rng);
+    fresh_scorer.init(shared, fresh, rng);
+    assert_close_score(
+        fresh_scorer.eval(shared, value, rng),
+        scorer.eval(shared, value, rng),
+        "Scorer::eval");
+
+    if (group.cache_is_current(shared)) {
+        const typename Model::Matrix L = group.post_psi_llt.matrixL();
+        const typename Model::Matrix post_psi =
+            shared.plus_group(group).psi;
+        DIST_ASSERT((L * L.transpose()).isApprox(post_psi, 1e-3f),
+            "stale cholesky factor");
+    }
+}
+
+// Values are added and removed against one Shared while the group is
+// also scored against another, which must not read the cached factor.
+template<class Model>
+void test_group_cache(size_t dim) {
+    typedef typename Model::Value Value;
+    const auto shared = example_shared<Model>(dim);
+    auto other = example_shared<Model>(dim);
+    other.mu.setConstant(1.f);
+    other.kappa = 2.5f;
+    other.psi *= 3.f;
+    other.psi(0, dim - 1) = other.psi(dim - 1, 0) = 0.5f;
+
+    typename Model::Group group;
+    group.init(shared, rng);
+    std::vector<Value> values;
+    for (size_t step = 0; step < 200; ++step) {
+        if (values.size() > 2 and sample_bernoulli(rng, 0.4f)) {
+            const size_t i = sample_int(rng, 0, values.size() - 1);
+            group.remove_value(shared, values[i], rng);
+            values.erase(values.begin() + i);
+        } else {
+            values.push_back(sample_near<Model>(dim, 2.f));
+            group.add_value(shared, values.back(), rng);
+        }
+        const Value value = sample_near<Model>(dim, 2.f);
+        assert_group_matches_fresh<Model>(shared, group, value);
+        assert_group_matches_fresh<Model>(other, group, value);
+    }
+
+    // the grid scores each shared against fresh factors where needed
+    typename Model::Mixture mixture;
+    mixture.groups().push_back(group);
+    mixture.init(shared, rng);
+    const std::vector<typename Model::Shared> shareds = {shared, other};
+    VectorFloat scores(shareds.size());
+    mixture.score_data_grid(shareds, scores, rng);
+    for (size_t i = 0; i < shareds.size(); ++i) {
+        typename Model::Group fresh = group;
+        fresh.invalidate_cache();
+        assert_close_score(
+            fresh.score_data(shareds[i], rng),
+            scores[i],
+            "score_data_grid");
+    }
+}
+
+// Assigning psi in place and calling changed() must retire the cache,
+// as must scoring against a copy.
+template<class Model>
+void test_shared_version(size_t dim) {
+    auto shared = example_shared<Model>(dim);
+    typename Model::Group group;
+    group.init(shared, rng);
+    for (size_t i = 0; i < 10; ++i) {
+        group.add_value(shared, sample_near<Model>(dim, 1.f), rng);
+    }
+    DIST_ASSERT(group.cache_is_current(shared), "expected current cache");
+
+    const typename Model::Shared copy = shared;
+    DIST_ASSERT(not group.cache_is_current(copy), "copy shares version");
+
+    shared.psi *= 2.f;
+    shared.changed();
+    DIST_ASSERT(not group.cache_is_current(shared), "expected stale cache");
+    assert_group_matches_fresh<Model>(
+        shared,
+        group,
+        sample_near<Model>(dim, 1.f));
+
+    group.add_value(shared, sample_near<Model>(dim, 1.f), rng);
+    DIST_ASSERT(group.cache_is_current(shared), "expected refreshed cache");
+    assert_group_matches_fresh<Model>(
+        shared,
+        group,
+        sample_near<Model>(dim, 1.f));
+}
+
+// FastMixture must agree with SmallMixture, which scores group by group,
+// as groups and values come and go.
+template<class Model>
+void test_fast_mixture(size_t dim) {
+    typedef typename Model::Value Value;
+    const auto shared = example_shared<Model>(dim);
+    typename Model::SmallMixture small;
+    typename Model::FastMixture fast;
+    for (size_t i = 0; i < 3; ++i) {
+        small.groups().emplace_back();
+        small.groups().back().init(shared, rng);
+    }
+    fast.groups() = small.groups();
+    small.init(shared, rng);
+    fast.init(shared, rng);
+
+    std::vector<std::pair<size_t, Value>> assigned;
+    for (size_t step = 0; step < 300; ++step) {
+        const size_t group_count = fast.groups().size();
+        if (step % 50 == 49) {
+            small.add_group(shared, rng);
+            fast.add_group(shared, rng);
+        } else if (assigned.size() > 2 and sample_bernoulli(rng, 0.4f)) {
+            const size_t i = sample_int(rng, 0, assigned.size() - 1);
+            const auto pair = assigned[i];
+            assigned.erase(assigned.begin() + i);
+            small.remove_value(shared, pair.first, pair.second, rng);
+            fast.remove_value(shared, pair.first, pair.second, rng);
+        } else {
+            const size_t groupid = sample_int(rng, 0, group_count - 1);
+            const Value value = sample_near<Model>(dim, 3.f * groupid);
+            small.add_value(shared, groupid, value, rng);
+            fast.add_value(shared, groupid, value, rng);
+            assigned.push_back(std::make_pair(groupid, value));
+        }
+    }
+
+    // remove the last group along with its values
+    const size_t last = fast.groups().size() - 1;
+    for (size_t i = 0; i < assigned.size(); ++i) {
+        if (assigned[i].first == last) {
+            small.remove_value(shared, last, assigned[i].second, rng);
+            fast.remove_value(shared, last, assigned[i].second, rng);
+        }
+    }
+    small.remove_group(shared, last);
+    fast.remove_group(shared, last);
+
+    const size_t group_count = fast.groups().size();
+    VectorFloat small_scores(group_count);
+    VectorFloat fast_scores(group_count);
+    for (size_t i = 0; i < 10; ++i) {
+        const Value value = sample_near<Model>(dim, 3.f);
+        std::fill(small_scores.begin(), small_scores.end(), 0);
+        std::fill(fast_scores.begin(), fast_scores.end(), 0);
+        small.score_value(shared, value, small_scores, rng);
+        fast.score_value(shared, value, fast_scores, rng);
+        for (size_t groupid = 0; groupid < group_count; ++groupid) {
+            assert_close_score(
+                small_scores[groupid],
+                fast_scores[groupid],
+                "FastMixture::score_value");
+        }
+    }
+    assert_close_score(
+        small.score_data(shared, rng),
+        fast.score_data(shared, rng),
+        "FastMixture::score_data");
+}
+
+// Groups are centered at multiples of offset away from shared.mu,
+// and values are added and removed many times to exercise the
+// rank-one updates and periodic refactoring.
+template<class Model>
+void test_mixture_score_value(size_t dim, float offset) {
+    typedef typename Model::Value Value;
+    const auto shared = example_shared<Model>(dim);
+    const size_t group_count = 5;
+
+    typename Model::Mixture mixture;
+    mixture.groups().resize(group_count);
+    for (auto & group : mixture.groups()) {
+        group.init(shared, rng);
+    }
+    mixture.init(shared, rng);
+
+    std::vector<std::vector<Value>> values(group_count);
+    for (size_t step = 0; step < 1000; ++step) {
+        const size_t groupid = sample_int(rng, 0, group_count - 1);
+        auto & group_values = values[groupid];
+        if (group_values.size() > 2 and sample_bernoulli(rng, 0.4f)) {
+            const size_t i = sample_int(rng, 0, group_values.size() - 1);
+            mixture.remove_value(shared, groupid, group_values[i], rng);
+            group_values.erase(group_values.begin() + i);
+        } else {
+            const float center = offset * (groupid + 1);
+            const Value value = sample_near<Model>(dim, center);
+            mixture.add_value(shared, groupid, value, rng);
+            group_values.push_back(value);
+        }
+    }
+
+    VectorFloat scores(group_count);
+    for (size_t groupid = 0; groupid < group_count; ++groupid) {
+        const float center = offset * (groupid + 1);
+        const Value value = sample_near<Model>(dim, center);
+        std::fill(scores.begin(), scores.end(), 0);
+        mixture.score_value(shared, value, scores, rng);
+        for (size_t i = 0; i < group_count; ++i) {
+            const float expected =
+                mixture.groups(i).score_value(shared, value, rng);
+            assert_close_score(expected, scores[i], "score_value");
+        }
+    }
+}
+
+int main() {
+    typedef NormalInverseWishart<-1> Dynamic;
+    test_group_cache<Dynamic>(3);
+    test_group_cache<Dynamic>(10);
+    test_group_cache<NormalInverseWishart<2>>(2);
+    test_group_cache<NormalInverseWishart<16>>(16);
+    test_shared_version<Dynamic>(3);
+    test_shared_version<NormalInverseWishart<4>>(4);
+    test_fast_mixture<Dynamic>(3);
+    test_fast_mixture<NormalInverseWishart<3>>(3);
+    test_fast_mixture<NormalInverseWishart<8>>(8);
+    for (float offset : {0.f, 100.f, 1000.f}) {
+        test_mixture_score_value<Dynamic>(3, offset);
+        test_mixture_score_value<Dynamic>(10, offset);
+        test_mixture_score_value<Dynamic>(30, offset);
+        test_mixture_score_value<NormalInverseWishart<3>>(3, offset);
+        test_mixture_score_value<NormalInverseWishart<16>>(16, offset);
+    }
+    return 0;
+}
@@ -0,0 +1,164 @@
+// Copyright (c) 2014, Salesforce.com, Inc.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+// - Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// - Neither the name of Salesforce.com nor the names of its contributors
+//   may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+// COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+// OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+// TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <stdint.h>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <distributions/pool_allocator.hpp>
+
+#if defined(__GLIBC__) and (__GLIBC__ > 2 or __GLIBC_MINOR__ >= 33)
+#  include <malloc.h>
+#  define DIST_HAS_MALLINFO2 1
+#else
+#  define DIST_HAS_MALLINFO2 0
+#endif
+
+// This checks MemoryPool size classes, alignment, cross-thread frees, the
+// max_free_bytes cap and the trim at thread exit, through pool_allocator.
+
+using namespace distributions;  // NOLINT(*)
+
+typedef pool_allocator<char> Allocator;
+
+size_t free_bytes() {
+    return MemoryPool::thread_local_pool().free_bytes();
+}
+
+// checks the bytes a freed request returns to the pool, and that a
+// request of the same size class reuses it
+void check_size_class(size_t bytes, size_t expected_block_bytes) {
+    Allocator allocator;
+    MemoryPool::thread_local_pool().trim();
+    char * data = allocator.allocate(bytes);
+    DIST_ASSERT_ALIGNED(data);
+    allocator.deallocate(data, bytes);
+    DIST_ASSERT_EQ(free_bytes(), expected_block_bytes);
+    if (expected_block_bytes) {
+        char * reused = allocator.allocate(expected_block_bytes);
+        DIST_ASSERT(reused == data,
+            bytes << " and " << expected_block_bytes <<
+            " bytes should share a size class");
+        allocator.deallocate(reused, expected_block_bytes);
+    }
+    MemoryPool::thread_local_pool().trim();
+}
+
+void test_size_classes() {
+    check_size_class(1, 32);
+    check_size_class(32, 32);
+    check_size_class(33, 64);
+    check_size_class(64, 64);
+    check_size_class(65, 128);
+    check_size_class(65536, 65536);
+    check_size_class(65537, 0);
+}
+
+void test_alignment() {
+    Allocator allocator;
+    std::vector<std::pair<char *, size_t>> blocks;
+    for (size_t bytes = 1; bytes <= 200000; bytes = bytes * 3 + 1) {
+        for (size_t i = 0; i < 3; ++i) {
+            char * data = allocator.allocate(bytes);
+            DIST_ASSERT_EQ(uintptr_t(data) % MemoryPool::alignment, 0);
+            blocks.push_back(std::make_pair(data, bytes));
+        }
+    }
+    for (const auto & block : blocks) {
+        allocator.deallocate(block.first, block.second);
+    }
+    MemoryPool::thread_local_pool().trim();
+}
+
+void test_cross_thread_free() {
+    Allocator allocator;
+    MemoryPool::thread_local_pool().trim();
+    char * data = nullptr;
+    std::thread([&]() { data = allocator.allocate(100); }).join();
+
+    // blocks freed here join this thread's pool
+    allocator.deallocate(data, 100);
+    DIST_ASSERT_EQ(free_bytes(), 128);
+    char * reused = allocator.allocate(100);
+    DIST_ASSERT(reused == data, "cross-thread block was not reused");
+    allocator.deallocate(reused, 100);
+    MemoryPool::thread_local_pool().trim();
+}
+
+void test_max_free_bytes() {
+    Allocator allocator;
+    MemoryPool::thread_local_pool().trim();
+    const size_t bytes = MemoryPool::max_block_bytes;
+    const size_t count = MemoryPool::max_free_bytes / bytes + 10;
+    std::vector<char *> blocks;
+    for (size_t i = 0; i < count; ++i) {
+        blocks.push_back(allocator.allocate(bytes));
+    }
+    for (char * data : blocks) {
+        allocator.deallocate(data, bytes);
+        DIST_ASSERT_LE(free_bytes(), MemoryPool::max_free_bytes);
+    }
+    DIST_ASSERT_EQ(free_bytes(), MemoryPool::max_free_bytes);
+    MemoryPool::thread_local_pool().trim();
+    DIST_ASSERT_EQ(free_bytes(), 0);
+}
+
+void test_thread_exit_trim() {
+#if DIST_HAS_MALLINFO2
+    const size_t pooled_bytes = 16UL << 20;
+    const size_t in_use_before = mallinfo2().uordblks;
+    size_t pooled_in_thread = 0;
+    std::thread([&]() {
+        Allocator allocator;
+        const size_t bytes = MemoryPool::max_block_bytes;
+        std::vector<char *> blocks;
+        for (size_t i = 0; i < pooled_bytes / bytes; ++i) {
+            blocks.push_back(allocator.allocate(bytes));
+        }
+        for (char * data : blocks) {
+            allocator.deallocate(data, bytes);
+        }
+        pooled_in_thread = free_bytes();
+    }).join();
+    const size_t in_use_after = mallinfo2().uordblks;
+
+    DIST_ASSERT_EQ(pooled_in_thread, pooled_bytes);
+    DIST_ASSERT(in_use_after < in_use_before + (1UL << 20),
+        "thread exit left " << (in_use_after - in_use_before) <<
+        " bytes allocated");
+#endif  // DIST_HAS_MALLINFO2
+}
+
+int main() {
+    test_size_classes();
+    test_alignment();
+    test_cross_thread_free();
+    test_max_free_bytes();
+    test_thread_exit_trim();
+    return 0;
+}
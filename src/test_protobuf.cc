@@ -25,9 +25,19 @@
 // TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
 // USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+// errors must throw, so that corrupt streams can be observed
+#ifndef DIST_THROW_ON_ERROR
+#  define DIST_THROW_ON_ERROR 1
+#endif  // DIST_THROW_ON_ERROR
+
+#include <fstream>
+#include <stdexcept>
 #include <distributions/common.hpp>
 #include <distributions/assert_close.hpp>
 #include <distributions/io/protobuf.hpp>
+#include <distributions/io/protobuf_arena.hpp>
+#include <distributions/io/protobuf_stream.hpp>
+#include <distributions/io/snapshot.hpp>
 
 #include <distributions/models/bb.hpp>
 #include <distributions/models/bnb.hpp>
@@ -108,9 +118,196 @@ void test_model() {
     DIST_ASSERT_CLOSE(group_message, group_message1);
 }
 
+template <typename Model>
+void test_stream(const std::string & filename) {
+    typedef typename message<Model>::group_message_type GroupMessage;
+    typedef google::protobuf::RepeatedPtrField<GroupMessage> GroupMessages;
+
+    auto const shared = Model::Shared::EXAMPLE();
+    distributions::rng_t rng;
+    GroupMessages group_messages;
+    {
+        distributions::protobuf::GroupWriter<Model, GroupMessage> writer(
+            filename);
+        for (size_t i = 0; i < 10; ++i) {
+            typename Model::Group group;
+            group.init(shared, rng);
+            group.add_value(shared, group.sample_value(shared, rng), rng);
+            group.protobuf_dump(* group_messages.Add());
+            writer.write(group);
+        }
+        writer.close();
+    }
+
+    distributions::protobuf::GroupReader<Model, GroupMessage> reader(filename);
+    GroupMessage group_message;
+    int pos = 0;
+    reader.for_each([&](const typename Model::Group & group){
+        DIST_ASSERT_LT(pos, group_messages.size());
+        group.protobuf_dump(group_message);
+        DIST_ASSERT_CLOSE(group_message, group_messages.Get(pos));
+        ++pos;
+    });
+    DIST_ASSERT_EQ(pos, group_messages.size());
+
+    remove(filename.c_str());
+}
+
+template <typename Model>
+void test_arena(const std::string & filename) {
+    typedef typename message<Model>::shared_message_type SharedMessage;
+    typedef typename message<Model>::group_message_type GroupMessage;
+    typedef distributions::protobuf::ArenaDumper<
+        Model,
+        SharedMessage,
+        GroupMessage> Dumper;
+
+    auto const shared = Model::Shared::EXAMPLE();
+    distributions::rng_t rng;
+    std::vector<typename Model::Group> groups(10);
+    for (auto & group : groups) {
+        group.init(shared, rng);
+        group.add_value(shared, group.sample_value(shared, rng), rng);
+    }
+
+    Dumper dumper;
+    for (size_t size : {10, 3, 10}) {
+        std::vector<typename Model::Group> subset(
+            groups.begin(),
+            groups.begin() + size);
+        dumper.dump(shared, subset);
+        {
+            distributions::protobuf::OutFile file(filename);
+            dumper.write(file);
+            file.close();
+        }
+
+        Dumper loader;
+        {
+            distributions::protobuf::InFile file(filename);
+            loader.read(file);
+        }
+        DIST_ASSERT_EQ(loader.group_count(), size);
+        DIST_ASSERT_CLOSE(loader.shared_message(), dumper.shared_message());
+        for (size_t i = 0; i < size; ++i) {
+            DIST_ASSERT_CLOSE(
+                loader.group_message(i),
+                dumper.group_message(i));
+        }
+    }
+
+    remove(filename.c_str());
+}
+
+// A stream cut inside a size prefix is corrupt, not a clean end of stream.
+template <typename Model>
+void test_truncated_stream(const std::string & filename) {
+    typedef typename message<Model>::group_message_type GroupMessage;
+
+    auto const shared = Model::Shared::EXAMPLE();
+    distributions::rng_t rng;
+    std::vector<typename Model::Group> groups(3);
+    for (auto & group : groups) {
+        group.init(shared, rng);
+    }
+    {
+        distributions::protobuf::GroupWriter<Model, GroupMessage> writer(
+            filename);
+        writer.write_all(groups);
+        writer.close();
+    }
+    {
+        std::ofstream file(filename, std::ios::app | std::ios::binary);
+        file.write("\x05\x00", 2);
+    }
+
+    distributions::protobuf::GroupReader<Model, GroupMessage> reader(filename);
+    std::vector<typename Model::Group> groups1;
+    bool failed = false;
+    try {
+        reader.read_all(groups1);
+    } catch (std::runtime_error &) {
+        failed = true;
+    }
+    DIST_ASSERT(failed, "truncated size prefix was read as end of stream");
+    DIST_ASSERT_EQ(groups1.size(), groups.size());
+
+    remove(filename.c_str());
+}
+
+// models whose Shared and Group support flat snapshots
+#define DIST_SNAPSHOT_MODELS(x) \
+    x(BetaBernoulli) \
+    x(BetaNegativeBinomial) \
+    x(DirichletDiscrete16) \
+    x(GammaPoisson) \
+    x(NormalInverseChiSq)
+
+template <typename Model>
+void test_snapshot() {
+    typedef typename message<Model>::shared_message_type SharedMessage;
+    typedef typename message<Model>::group_message_type GroupMessage;
+    typedef google::protobuf::RepeatedPtrField<GroupMessage> GroupMessages;
+    const std::string filename = "test_snapshot.dist";
+
+    auto const shared = Model::Shared::EXAMPLE();
+    SharedMessage shared_message;
+    shared.protobuf_dump(shared_message);
+
+    distributions::rng_t rng;
+    GroupMessages group_messages;
+    for (size_t i = 0; i < 10; ++i) {
+        typename Model::Group group;
+        group.init(shared, rng);
+        for (size_t j = 0; j < i; ++j) {
+            group.add_value(shared, group.sample_value(shared, rng), rng);
+        }
+        group.protobuf_dump(* group_messages.Add());
+    }
+
+    distributions::snapshot_dump_protobuf<Model>(
+        filename,
+        shared_message,
+        group_messages);
+
+    SharedMessage shared_message1;
+    GroupMessages group_messages1;
+    distributions::snapshot_load_protobuf<Model>(
+        filename,
+        shared_message1,
+        group_messages1);
+    DIST_ASSERT_CLOSE(shared_message, shared_message1);
+    DIST_ASSERT_EQ(group_messages.size(), group_messages1.size());
+    for (int i = 0; i < group_messages.size(); ++i) {
+        DIST_ASSERT_CLOSE(group_messages.Get(i), group_messages1.Get(i));
+    }
+
+    typename Model::Shared shared1;
+    typename Model::Mixture mixture;
+    distributions::Snapshot<Model>(filename).restore(shared1, mixture, rng);
+    const size_t group_count = group_messages.size();
+    DIST_ASSERT_EQ(mixture.groups().size(), group_count);
+
+    remove(filename.c_str());
+}
+
 int main(void) {
 #define DIST_TEST_MODEL(name) test_model<distributions::name>();
     DIST_MODELS(DIST_TEST_MODEL);
 #undef DIST_TEST_MODEL
+#define DIST_TEST_STREAM(name) \
+    test_stream<distributions::name>("test_stream.pbs"); \
+    test_stream<distributions::name>("test_stream.pbs.gz");
+    DIST_MODELS(DIST_TEST_STREAM);
+#undef DIST_TEST_STREAM
+#define DIST_TEST_ARENA(name) \
+    test_arena<distributions::name>("test_arena.pbs");
+    DIST_MODELS(DIST_TEST_ARENA);
+#undef DIST_TEST_ARENA
+    test_truncated_stream<distributions::NormalInverseChiSq>(
+        "test_truncated.pbs");
+#define DIST_TEST_SNAPSHOT(name) test_snapshot<distributions::name>();
+    DIST_SNAPSHOT_MODELS(DIST_TEST_SNAPSHOT);
+#undef DIST_TEST_SNAPSHOT
     return 0;
 }
@@ -0,0 +1,121 @@
+// Copyright (c) 2014, Salesforce.com, Inc.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+// - Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// - Neither the name of Salesforce.com nor the names of its contributors
+//   may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+// COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+// OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+// TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <vector>
+#include <distributions/random.hpp>
+#include <distributions/models/bb.hpp>
+#include <distributions/models/dd.hpp>
+#include <distributions/models/gp.hpp>
+#include <distributions/models/nich.hpp>
+
+// This checks that mixture score_data stays accurate on models with many
+// groups, where float accumulation would lose several digits.
+
+using namespace distributions;  // NOLINT(*)
+
+rng_t rng;
+
+const size_t group_count = 100000;
+const double tol = 1e-5;
+
+template<class Model>
+void init_mixture(
+        typename Model::Mixture & mixture,
+        const typename Model::Shared & shared) {
+    typename Model::Group empty;
+    empty.init(shared, rng);
+    typename Model::Sampler sampler;
+    sampler.init(shared, empty, rng);
+
+    mixture.groups().resize(group_count);
+    for (auto & group : mixture.groups()) {
+        group.init(shared, rng);
+        for (size_t i = 0, size = sample_int(rng, 1, 20); i < size; ++i) {
+            group.add_value(shared, sampler.eval(shared, rng), rng);
+        }
+    }
+    mixture.init(shared, rng);
+}
+
+template<class Mixture, class Shared>
+long double score_groups(const Mixture & mixture, const Shared & shared) {
+    long double score = 0;
+    for (const auto & group : mixture.groups()) {
+        score += group.score_data(shared, rng);
+    }
+    return score;
+}
+
+void assert_accurate(
+        const char * name,
+        long double expected,
+        float actual) {
+    const long double error = fabsl(actual - expected) / fabsl(expected);
+    DIST_ASSERT(error < tol,
+        name << " score_data relative error " << error);
+}
+
+template<class Model>
+void test_score_data(const char * name) {
+    const auto shared = Model::Shared::EXAMPLE();
+    typename Model::Mixture mixture;
+    init_mixture<Model>(mixture, shared);
+    assert_accurate(
+        name,
+        score_groups(mixture, shared),
+        mixture.score_data(shared, rng));
+}
+
+void test_score_data_grid() {
+    typedef DirichletDiscrete<16> Model;
+    const auto shared = Model::Shared::EXAMPLE();
+    Model::Mixture mixture;
+    init_mixture<Model>(mixture, shared);
+
+    std::vector<Model::Shared> shareds(4, shared);
+    for (size_t i = 0; i < shareds.size(); ++i) {
+        shareds[i].alphas[i] *= 2;
+    }
+    VectorFloat scores(shareds.size());
+    mixture.score_data_grid(shareds, scores, rng);
+    for (size_t i = 0; i < shareds.size(); ++i) {
+        assert_accurate(
+            "dd grid",
+            score_groups(mixture, shareds[i]),
+            scores[i]);
+    }
+}
+
+int main() {
+    test_score_data<BetaBernoulli>("bb");
+    test_score_data<DirichletDiscrete<16>>("dd");
+    test_score_data<GammaPoisson>("gp");
+    test_score_data<NormalInverseChiSq>("nich");
+    test_score_data_grid();
+    return 0;
+}
@@ -0,0 +1,144 @@
+// Copyright (c) 2014, Salesforce.com, Inc.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+// - Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// - Neither the name of Salesforce.com nor the names of its contributors
+//   may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+// COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+// OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+// TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <distributions/assert_close.hpp>
+#include <distributions/float16.hpp>
+#include <distributions/random.hpp>
+#include <distributions/models/bb.hpp>
+#include <distributions/models/dd.hpp>
+#include <distributions/models/nich.hpp>
+
+// This checks that mixtures caching scores in 16 bits agree with the
+// float mixtures, within the precision of the storage type.
+
+using namespace distributions;  // NOLINT(*)
+
+rng_t rng;
+
+template<class Score>
+void test_round_trip(float tol) {
+    for (float x : {0.f, 1.f, -1.f, 0.5f, 0.375f, -2048.f}) {
+        DIST_ASSERT_EQ(float(Score(x)), x);
+    }
+    for (int i = 0; i < 1000; ++i) {
+        const float x = sample_std_normal(rng) * 100;
+        const float y = Score(x);
+        DIST_ASSERT(fabs(x - y) <= fabs(x) * tol,
+            "round trip of " << x << " gave " << y);
+    }
+}
+
+// inf and nan are checked by bits, since -ffast-math folds std::isinf
+void test_special_values() {
+    DIST_ASSERT_EQ(bfloat16_t(INFINITY).bits, 0x7f80);
+    DIST_ASSERT_EQ(bfloat16_t(-INFINITY).bits, 0xff80);
+    DIST_ASSERT_EQ(bfloat16_t(NAN).bits & 0x7fc0, 0x7fc0);
+    DIST_ASSERT_EQ(float16_t(INFINITY).bits, 0x7c00);
+    DIST_ASSERT_EQ(float16_t(-INFINITY).bits, 0xfc00);
+    DIST_ASSERT_EQ(float16_t(NAN).bits & 0x7e00, 0x7e00);
+    DIST_ASSERT_EQ(float_to_bits(float16_t::to_float(0x7c00)), 0x7f800000u);
+}
+
+void test_float16_range() {
+    DIST_ASSERT_EQ(float(float16_t(65504.f)), 65504.f);
+    DIST_ASSERT_EQ(float16_t(1e5f).bits, 0x7c00);
+    DIST_ASSERT_EQ(float(float16_t(std::ldexp(1.f, -24))),
+        std::ldexp(1.f, -24));
+    DIST_ASSERT_EQ(float(float16_t(std::ldexp(1.f, -26))), 0.f);
+    DIST_ASSERT_LE(fabs(float(bfloat16_t(1e30f)) - 1e30f), 1e30f / 256);
+}
+
+template<class Model, class ReducedMixture>
+void test_mixture(const char * name) {
+    typedef typename Model::Value Value;
+    typedef typename Model::Shared Shared;
+    typedef typename Model::Group Group;
+    typedef typename Model::Mixture Mixture;
+
+    const size_t group_count = 20;
+    const size_t value_count = 50;
+    Shared shared = Shared::EXAMPLE();
+
+    Group empty;
+    empty.init(shared, rng);
+    typename Model::Sampler sampler;
+    sampler.init(shared, empty, rng);
+    std::vector<Value> values;
+    for (size_t i = 0; i < value_count; ++i) {
+        values.push_back(sampler.eval(shared, rng));
+    }
+
+    Mixture mixture;
+    ReducedMixture reduced;
+    mixture.groups().resize(group_count);
+    reduced.groups().resize(group_count);
+    for (size_t i = 0; i < group_count; ++i) {
+        mixture.groups()[i].init(shared, rng);
+        reduced.groups()[i].init(shared, rng);
+    }
+    mixture.init(shared, rng);
+    reduced.init(shared, rng);
+    for (size_t i = 0; i < value_count; ++i) {
+        const size_t groupid = i % group_count;
+        mixture.add_value(shared, groupid, values[i], rng);
+        reduced.add_value(shared, groupid, values[i], rng);
+    }
+
+    VectorFloat expected(group_count);
+    VectorFloat actual(group_count);
+    for (const auto & value : values) {
+        std::fill(expected.begin(), expected.end(), 0);
+        std::fill(actual.begin(), actual.end(), 0);
+        mixture.score_value(shared, value, expected, rng);
+        reduced.score_value(shared, value, actual, rng);
+        for (size_t i = 0; i < group_count; ++i) {
+            DIST_ASSERT(are_close(expected[i], actual[i]),
+                name << " score " << actual[i] << " vs " << expected[i]);
+        }
+    }
+}
+
+int main() {
+    test_round_trip<bfloat16_t>(1.f / 256);
+    test_round_trip<float16_t>(1.f / 2048);
+    test_special_values();
+    test_float16_range();
+    typedef DirichletDiscrete<16> DD;
+    test_mixture<BetaBernoulli, BetaBernoulli::BFloat16Mixture>("bb");
+    test_mixture<BetaBernoulli, BetaBernoulli::Float16Mixture>("bb");
+    test_mixture<DD, DD::BFloat16Mixture>("dd");
+    test_mixture<DD, DD::Float16Mixture>("dd");
+    test_mixture<NormalInverseChiSq, NormalInverseChiSq::BFloat16Mixture>(
+        "nich");
+    test_mixture<NormalInverseChiSq, NormalInverseChiSq::Float16Mixture>(
+        "nich");
+    return 0;
+}
@@ -0,0 +1,104 @@
+// Copyright (c) 2014, Salesforce.com, Inc.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+// - Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// - Neither the name of Salesforce.com nor the names of its contributors
+//   may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+// COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+// OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+// TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <distributions/random.hpp>
+#include <distributions/models/gp.hpp>
+#include <distributions/models/nich.hpp>
+
+// This checks that the tiled Mixture::score_values agrees with scoring
+// each value by Mixture::score_value, for group and value counts that are
+// not multiples of the tile sizes (256 groups x 64 values).
+
+using namespace distributions;  // NOLINT(*)
+
+rng_t rng;
+
+template<class Model, class Mixture>
+void test_score_values(size_t group_count, size_t value_count) {
+    typedef typename Model::Value Value;
+    const auto shared = Model::Shared::EXAMPLE();
+
+    Mixture mixture;
+    mixture.groups().resize(group_count);
+    for (auto & group : mixture.groups()) {
+        group.init(shared, rng);
+        for (size_t i = 0, size = sample_int(rng, 0, 5); i < size; ++i) {
+            group.add_value(shared, group.sample_value(shared, rng), rng);
+        }
+    }
+    mixture.init(shared, rng);
+
+    std::vector<Value> values;
+    for (size_t v = 0; v < value_count; ++v) {
+        const size_t groupid = sample_int(rng, 0, group_count - 1);
+        values.push_back(mixture.groups(groupid).sample_value(shared, rng));
+    }
+
+    // score_values accumulates, so start from nonzero scores
+    VectorFloat actual(value_count * group_count);
+    for (auto & score : actual) {
+        score = sample_std_normal(rng);
+    }
+    VectorFloat expected = actual;
+    mixture.score_values(shared, values, actual, rng);
+
+    VectorFloat row(group_count);
+    for (size_t v = 0; v < value_count; ++v) {
+        float * expected_row = expected.data() + v * group_count;
+        std::copy(expected_row, expected_row + group_count, row.begin());
+        mixture.score_value(shared, values[v], row, rng);
+        for (size_t i = 0; i < group_count; ++i) {
+            const float x = row[i];
+            const float y = actual[v * group_count + i];
+            DIST_ASSERT(std::fabs(x - y) <= 1e-5f * (1.f + std::fabs(x)),
+                "score_values differs from score_value at value " << v <<
+                " of " << value_count << ", group " << i <<
+                " of " << group_count << ": " << y << " vs " << x);
+        }
+    }
+}
+
+template<class Model, class Mixture = typename Model::Mixture>
+void test_model() {
+    for (size_t group_count : {1, 255, 256, 257, 1000}) {
+        for (size_t value_count : {1, 63, 65, 130}) {
+            test_score_values<Model, Mixture>(group_count, value_count);
+        }
+    }
+}
+
+int main() {
+    test_model<NormalInverseChiSq>();
+    test_model<NormalInverseChiSq, NormalInverseChiSq::BFloat16Mixture>();
+    test_model<NormalInverseChiSq, NormalInverseChiSq::Float16Mixture>();
+    test_model<GammaPoisson>();
+    return 0;
+}
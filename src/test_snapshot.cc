@@ -0,0 +1,133 @@
+// Copyright (c) 2014, Salesforce.com, Inc.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+// - Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// - Neither the name of Salesforce.com nor the names of its contributors
+//   may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+// COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+// OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+// TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// errors must throw, so that failed loads can be observed
+#ifndef DIST_THROW_ON_ERROR
+#  define DIST_THROW_ON_ERROR 1
+#endif  // DIST_THROW_ON_ERROR
+
+#include <stdio.h>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <distributions/io/snapshot.hpp>
+#include <distributions/models/gp.hpp>
+#include <distributions/models/nich.hpp>
+
+// This checks that Snapshots round trip, and that a Snapshot whose
+// validation fails throws without leaving its file mapped.
+
+using namespace distributions;  // NOLINT(*)
+
+typedef NormalInverseChiSq Model;
+
+rng_t rng;
+
+// counts this process's mappings of filename, per /proc/self/maps
+size_t count_mappings(const std::string & filename) {
+    std::ifstream maps("/proc/self/maps");
+    std::string line;
+    size_t count = 0;
+    while (std::getline(maps, line)) {
+        const std::string suffix = "/" + filename;
+        if (line.size() >= suffix.size() and
+                line.compare(line.size() - suffix.size(), suffix.size(),
+                             suffix) == 0) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+std::string read_file(const std::string & filename) {
+    std::ifstream file(filename, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), {});
+}
+
+void write_file(const std::string & filename, const std::string & data) {
+    std::ofstream file(filename, std::ios::binary);
+    file.write(data.data(), data.size());
+}
+
+template<class SnapshotModel>
+void check_load_fails(const std::string & filename) {
+    bool failed = false;
+    try {
+        Snapshot<SnapshotModel> snapshot(filename);
+    } catch (std::runtime_error &) {
+        failed = true;
+    }
+    DIST_ASSERT(failed, "loading " << filename << " should have failed");
+    DIST_ASSERT_EQ(count_mappings(filename), 0);
+}
+
+int main() {
+    const std::string filename = "test_snapshot.dist";
+    const std::string corrupt_filename = "test_snapshot_corrupt.dist";
+
+    const auto shared = Model::Shared::EXAMPLE();
+    std::vector<Model::Group> groups(10);
+    for (auto & group : groups) {
+        group.init(shared, rng);
+        group.add_value(shared, group.sample_value(shared, rng), rng);
+    }
+    snapshot_dump<Model>(filename, shared, groups);
+
+    {
+        Snapshot<Model> snapshot(filename);
+        DIST_ASSERT_EQ(count_mappings(filename), 1);
+        Model::Shared shared1;
+        Model::Mixture mixture;
+        snapshot.restore(shared1, mixture, rng);
+        DIST_ASSERT_EQ(mixture.groups().size(), groups.size());
+        for (size_t i = 0; i < groups.size(); ++i) {
+            DIST_ASSERT_EQ(mixture.groups(i).count, groups[i].count);
+        }
+    }
+    DIST_ASSERT_EQ(count_mappings(filename), 0);
+
+    // a snapshot of another model fails validation
+    check_load_fails<GammaPoisson>(filename);
+
+    // a corrupted group fails the checksum
+    std::string data = read_file(filename);
+    data[data.size() - 1] ^= 1;
+    write_file(corrupt_filename, data);
+    check_load_fails<Model>(corrupt_filename);
+
+    // trailing bytes fail the size check
+    data = read_file(filename) + "extra";
+    write_file(corrupt_filename, data);
+    check_load_fails<Model>(corrupt_filename);
+
+    remove(filename.c_str());
+    remove(corrupt_filename.c_str());
+    return 0;
+}
@@ -0,0 +1,157 @@
+// Copyright (c) 2014, Salesforce.com, Inc.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+// - Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// - Neither the name of Salesforce.com nor the names of its contributors
+//   may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+// COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+// OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+// TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <distributions/random.hpp>
+#include <distributions/tempering.hpp>
+#include <distributions/models/nich.hpp>
+
+// This runs parallel tempering on a column drawn from two well separated
+// normals, and checks that chains stay consistent, that results do not
+// depend on how chains are scheduled across threads, and that long runs
+// neither accumulate threads nor leak per-thread memory.
+
+using namespace distributions;  // NOLINT(*)
+
+typedef ParallelTempering<NormalInverseChiSq> Tempering;
+
+rng_t rng;
+
+std::shared_ptr<const Tempering::Column> sample_column(size_t row_count) {
+    auto column = std::make_shared<Tempering::Column>();
+    for (size_t row = 0; row < row_count; ++row) {
+        const float mean = (row % 2) ? -5.f : 5.f;
+        column->push_back(mean + sample_std_normal(rng));
+    }
+    return column;
+}
+
+Tempering new_tempering(
+        std::shared_ptr<const Tempering::Column> column,
+        rng_t::result_type seed) {
+    Clustering<int>::PitmanYor clustering;
+    clustering.alpha = 1.f;
+    clustering.d = 0.1f;
+    const std::vector<float> betas = {1.f, 0.5f, 0.25f, 0.125f};
+    return Tempering(
+        clustering,
+        NormalInverseChiSq::Shared::EXAMPLE(),
+        column,
+        betas,
+        seed);
+}
+
+void check_chain(const Tempering::Chain & chain, size_t row_count) {
+    const auto & counts = chain.clustering_mixture().counts();
+    const auto & groups = chain.mixture().groups();
+    DIST_ASSERT_EQ(counts.size(), groups.size());
+
+    std::vector<int> expected(counts.size(), 0);
+    for (size_t groupid : chain.assignments()) {
+        DIST_ASSERT_LT(groupid, expected.size());
+        ++expected[groupid];
+    }
+    size_t total = 0;
+    for (size_t groupid = 0; groupid < counts.size(); ++groupid) {
+        DIST_ASSERT_EQ(counts[groupid], expected[groupid]);
+        DIST_ASSERT_EQ(groups[groupid].count, expected[groupid]);
+        total += counts[groupid];
+    }
+    DIST_ASSERT_EQ(total, row_count);
+}
+
+// returns a field of /proc/self/status, e.g. Threads or VmRSS (in kB)
+size_t proc_status(const std::string & name) {
+    std::ifstream file("/proc/self/status");
+    std::string key;
+    size_t value;
+    while (file >> key) {
+        if (key == name + ":" and file >> value) {
+            return value;
+        }
+    }
+    return 0;
+}
+
+void test_long_run(std::shared_ptr<const Tempering::Column> column) {
+    const size_t thread_count = 4;
+    Tempering tempering = new_tempering(column, 1);
+    tempering.run(20, 1, thread_count);
+    const size_t threads_before = proc_status("Threads");
+    const size_t rss_before = proc_status("VmRSS");
+
+    tempering.run(5000, 1, thread_count);
+    const size_t threads_after = proc_status("Threads");
+    const size_t rss_after = proc_status("VmRSS");
+
+    // pool workers outlive each run, and are reused by the next
+    DIST_ASSERT_EQ(ThreadPool::global().worker_count(), thread_count - 1);
+    DIST_ASSERT_EQ(threads_after, threads_before);
+    DIST_ASSERT(rss_after <= rss_before + 256,
+        "RSS grew from " << rss_before << "kB to " << rss_after << "kB");
+}
+
+int main() {
+    const size_t row_count = 200;
+    const auto column = sample_column(row_count);
+
+    Tempering serial = new_tempering(column, 0);
+    Tempering parallel = new_tempering(column, 0);
+    serial.run(20, 2, 1);
+    parallel.run(20, 2, 4);
+    DIST_ASSERT_EQ(column.use_count(), 3);
+
+    for (size_t rank = 0; rank < parallel.chain_count(); ++rank) {
+        check_chain(parallel.chain(rank), row_count);
+        DIST_ASSERT(
+            serial.chain(rank).assignments() ==
+            parallel.chain(rank).assignments(),
+            "chain " << rank << " depends on thread scheduling");
+    }
+    for (size_t rank = 0; rank + 1 < parallel.chain_count(); ++rank) {
+        const float acceptance = parallel.swap_acceptance(rank);
+        DIST_ASSERT(0 <= acceptance and acceptance <= 1,
+            "bad swap acceptance: " << acceptance);
+    }
+
+    // the cold chain should separate the two modes
+    const auto & cold = parallel.chain(0);
+    const auto assignments = cold.assignments();
+    const auto & groups = cold.mixture().groups();
+    for (size_t row = 0; row < row_count; ++row) {
+        const float mean = groups[assignments[row]].mean;
+        DIST_ASSERT(((row % 2) ? -mean : mean) > 0,
+            "row " << row << " is in a group with mean " << mean);
+    }
+
+    test_long_run(sample_column(20));
+    return 0;
+}
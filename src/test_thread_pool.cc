@@ -0,0 +1,122 @@
+// Copyright (c) 2014, Salesforce.com, Inc.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+// - Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// - Neither the name of Salesforce.com nor the names of its contributors
+//   may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+// COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+// OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+// TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+#include <distributions/clustering.hpp>
+#include <distributions/random.hpp>
+#include <distributions/thread_pool.hpp>
+
+// This checks that ThreadPool runs every task exactly once, that nested
+// and concurrent batches complete, and that its workers persist across
+// batches rather than being respawned.
+
+using namespace distributions;  // NOLINT(*)
+
+rng_t rng;
+
+void test_each_task_once(ThreadPool & pool) {
+    for (size_t task_count : {0, 1, 7, 1000}) {
+        for (size_t thread_count : {1, 2, 4, 8}) {
+            std::vector<std::atomic<int>> runs(task_count);
+            for (auto & run : runs) {
+                run = 0;
+            }
+            pool.parallel_for(task_count, thread_count, [&](size_t i) {
+                ++runs[i];
+            });
+            for (size_t i = 0; i < task_count; ++i) {
+                DIST_ASSERT_EQ(runs[i], 1);
+            }
+        }
+    }
+}
+
+void test_nested(ThreadPool & pool) {
+    std::atomic<size_t> total(0);
+    pool.parallel_for(8, 4, [&](size_t) {
+        pool.parallel_for(10, 4, [&](size_t i) { total += i; });
+    });
+    DIST_ASSERT_EQ(total, 8 * 45);
+}
+
+void test_concurrent_callers(ThreadPool & pool) {
+    std::atomic<size_t> total(0);
+    auto call = [&]() {
+        for (size_t batch = 0; batch < 100; ++batch) {
+            pool.parallel_for(10, 4, [&](size_t i) { total += i; });
+        }
+    };
+    std::thread other(call);
+    call();
+    other.join();
+    DIST_ASSERT_EQ(total, 2 * 100 * 45);
+}
+
+void test_persistent_workers() {
+    ThreadPool pool;
+    std::mutex mutex;
+    std::set<std::thread::id> ids;
+    for (size_t batch = 0; batch < 1000; ++batch) {
+        pool.parallel_for(16, 4, [&](size_t) {
+            std::unique_lock<std::mutex> lock(mutex);
+            ids.insert(std::this_thread::get_id());
+        });
+    }
+    DIST_ASSERT_EQ(pool.worker_count(), 3);
+    DIST_ASSERT_LE(ids.size(), 4);
+}
+
+void test_count_assignments() {
+    const size_t size = 5UL << 20;
+    std::vector<int> assignments(size);
+    std::vector<int> expected(100, 0);
+    for (auto & groupid : assignments) {
+        groupid = sample_int(rng, 0, 99);
+        ++expected[groupid];
+    }
+    const auto counts = Clustering<int>::count_assignments(assignments);
+    DIST_ASSERT_EQ(counts.size(), expected.size());
+    for (size_t i = 0; i < counts.size(); ++i) {
+        DIST_ASSERT_EQ(counts[i], expected[i]);
+    }
+}
+
+int main() {
+    ThreadPool pool;
+    test_each_task_once(pool);
+    test_nested(pool);
+    test_concurrent_callers(pool);
+    test_each_task_once(ThreadPool::global());
+    test_persistent_workers();
+    test_count_assignments();
+    return 0;
+}
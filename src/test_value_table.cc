@@ -0,0 +1,135 @@
+// Copyright (c) 2014, Salesforce.com, Inc.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+// - Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// - Neither the name of Salesforce.com nor the names of its contributors
+//   may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+// COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+// OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+// TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+#include <distributions/random.hpp>
+#include <distributions/models/bnb.hpp>
+#include <distributions/models/gp.hpp>
+
+// This checks that the cached value rows of GP and BNB mixtures stay in
+// sync with their groups through add_value, remove_value, add_group and
+// remove_group, including values beyond the cached rows.
+
+using namespace distributions;  // NOLINT(*)
+
+rng_t rng;
+
+template<class Model>
+void check_scores(
+        const typename Model::Shared & shared,
+        const typename Model::Mixture & mixture) {
+    const size_t group_count = mixture.groups().size();
+    VectorFloat scores(group_count);
+    for (uint32_t value = 0; value < 80; ++value) {
+        std::fill(scores.begin(), scores.end(), 0);
+        mixture.score_value(shared, value, scores, rng);
+        for (size_t i = 0; i < group_count; ++i) {
+            const float expected =
+                mixture.groups(i).score_value(shared, value, rng);
+            DIST_ASSERT(
+                std::fabs(scores[i] - expected) <=
+                    1e-3f * (1.f + std::fabs(expected)),
+                "stale score for value " << value << ", group " << i <<
+                ": " << scores[i] << " vs " << expected);
+        }
+    }
+}
+
+template<class Model>
+void test_value_table() {
+    typedef typename Model::Value Value;
+    const auto shared = Model::Shared::EXAMPLE();
+
+    typename Model::Mixture mixture;
+    mixture.groups().resize(10);
+    for (auto & group : mixture.groups()) {
+        group.init(shared, rng);
+    }
+    mixture.init(shared, rng);
+
+    std::vector<std::pair<size_t, Value>> assigned;
+    for (size_t step = 0; step < 2000; ++step) {
+        const size_t group_count = mixture.groups().size();
+        switch (sample_int(rng, 0, 7)) {
+            case 0:
+                mixture.add_group(shared, rng);
+                break;
+
+            case 1:
+                if (group_count > 1) {
+                    const size_t groupid = sample_int(rng, 0, group_count - 1);
+                    mixture.remove_group(shared, groupid);
+                    // packed_remove moves the last group into groupid
+                    std::vector<std::pair<size_t, Value>> kept;
+                    for (auto pair : assigned) {
+                        if (pair.first != groupid) {
+                            if (pair.first == group_count - 1) {
+                                pair.first = groupid;
+                            }
+                            kept.push_back(pair);
+                        }
+                    }
+                    assigned.swap(kept);
+                }
+                break;
+
+            case 2:
+            case 3:
+                if (not assigned.empty()) {
+                    const size_t pos = sample_int(rng, 0, assigned.size() - 1);
+                    std::swap(assigned[pos], assigned.back());
+                    const auto pair = assigned.back();
+                    assigned.pop_back();
+                    mixture.remove_value(shared, pair.first, pair.second, rng);
+                }
+                break;
+
+            default: {
+                const size_t groupid = sample_int(rng, 0, group_count - 1);
+                const Value value = sample_int(rng, 0, 79);
+                mixture.add_value(shared, groupid, value, rng);
+                assigned.push_back(std::make_pair(groupid, value));
+            } break;
+        }
+
+        if (step % 100 == 0) {
+            mixture.validate(shared);
+            check_scores<Model>(shared, mixture);
+        }
+    }
+    check_scores<Model>(shared, mixture);
+}
+
+int main() {
+    test_value_table<GammaPoisson>();
+    test_value_table<BetaNegativeBinomial>();
+    return 0;
+}
@@ -0,0 +1,124 @@
+// Copyright (c) 2014, Salesforce.com, Inc.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+// - Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// - Neither the name of Salesforce.com nor the names of its contributors
+//   may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+// COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+// OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+// TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <distributions/thread_pool.hpp>
+
+namespace distributions {
+
+ThreadPool::~ThreadPool() {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto & worker : workers_) {
+        worker.join();
+    }
+}
+
+ThreadPool & ThreadPool::global() {
+    static ThreadPool pool;
+    return pool;
+}
+
+size_t ThreadPool::worker_count() const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return workers_.size();
+}
+
+void ThreadPool::parallel_for(
+        size_t task_count,
+        size_t thread_count,
+        const Task & task) {
+    thread_count = std::min(thread_count, task_count);
+    if (thread_count <= 1 or running_.exchange(true)) {
+        for (size_t i = 0; i < task_count; ++i) {
+            task(i);
+        }
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        const size_t worker_count = thread_count - 1;
+        while (workers_.size() < worker_count) {
+            workers_.push_back(std::thread(&ThreadPool::_work, this));
+        }
+        task_ = & task;
+        task_count_ = task_count;
+        next_task_ = 0;
+        open_slots_ = worker_count;
+        ++batch_;
+    }
+    wake_.notify_all();
+
+    _run_tasks();
+
+    {
+        // workers that have not yet woken will skip this batch
+        std::unique_lock<std::mutex> lock(mutex_);
+        open_slots_ = 0;
+        done_.wait(lock, [this]() { return busy_workers_ == 0; });
+        task_ = nullptr;
+    }
+    running_ = false;
+}
+
+void ThreadPool::_run_tasks() {
+    size_t i;
+    while ((i = next_task_++) < task_count_) {
+        (*task_)(i);
+    }
+}
+
+void ThreadPool::_work() {
+    uint64_t seen_batch = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        wake_.wait(lock, [&]() {
+            return stopping_ or batch_ != seen_batch;
+        });
+        if (stopping_) {
+            return;
+        }
+        seen_batch = batch_;
+        if (open_slots_ == 0) {
+            continue;
+        }
+        --open_slots_;
+        ++busy_workers_;
+        lock.unlock();
+        _run_tasks();
+        lock.lock();
+        if (--busy_workers_ == 0) {
+            done_.notify_all();
+        }
+    }
+}
+
+}   // namespace distributions
@@ -26,6 +26,7 @@
 // USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <distributions/special.hpp>
+#include <distributions/vector_math.hpp>
 
 #if defined  USE_YEPPP
 
@@ -92,6 +93,16 @@ float vector_sum(
     return res;
 }
 
+double vector_sum(
+        const size_t size,
+        const double * __restrict__ in) {
+    double res = 0;
+    for (size_t i = 0; i < size; ++i) {
+        res += in[i];
+    }
+    return res;
+}
+
 float vector_dot(
         const size_t size,
         const float * __restrict__ in1,
@@ -290,5 +301,109 @@ void vector_lgamma_nu(
     }
 }
 
+// --------------------------------------------------------------------------
+// Reduced-precision storage
+
+// These convert a prefix of the input with SIMD where the hardware
+// supports it, returning the number of elements done.
+
+inline size_t vector_add_simd(size_t, float *, const bfloat16_t *) {
+    return 0;
+}
+
+inline size_t vector_add_subtract_simd(
+        size_t,
+        float *,
+        const bfloat16_t *,
+        const float *) {
+    return 0;
+}
+
+#ifdef __F16C__
+
+inline __m128 load_float16x4(const float16_t * in) {
+    return _mm_cvtph_ps(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i *>(in)));
+}
+
+inline size_t vector_add_simd(
+        size_t size,
+        float * __restrict__ io,
+        const float16_t * __restrict__ in) {
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m128 sum = _mm_add_ps(_mm_loadu_ps(io + i), load_float16x4(in + i));
+        _mm_storeu_ps(io + i, sum);
+    }
+    return i;
+}
+
+inline size_t vector_add_subtract_simd(
+        size_t size,
+        float * __restrict__ io,
+        const float16_t * __restrict__ in1,
+        const float * __restrict__ in2) {
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m128 diff =
+            _mm_sub_ps(load_float16x4(in1 + i), _mm_loadu_ps(in2 + i));
+        _mm_storeu_ps(io + i, _mm_add_ps(_mm_loadu_ps(io + i), diff));
+    }
+    return i;
+}
+
+#else  // __F16C__
+
+inline size_t vector_add_simd(size_t, float *, const float16_t *) {
+    return 0;
+}
+
+inline size_t vector_add_subtract_simd(
+        size_t,
+        float *,
+        const float16_t *,
+        const float *) {
+    return 0;
+}
+
+#endif  // __F16C__
+
+#define DEFINE_REDUCED_PRECISION_KERNELS(Score)             \
+    void vector_add(                                        \
+            const size_t size,                              \
+            float * __restrict__ io,                        \
+            const Score * __restrict__ in) {                \
+        size_t i = vector_add_simd(size, io, in);           \
+        for (; i < size; ++i) {                             \
+            io[i] += static_cast<float>(in[i]);             \
+        }                                                   \
+    }                                                       \
+                                                            \
+    void vector_add_subtract(                               \
+            const size_t size,                              \
+            float * __restrict__ io,                        \
+            const Score * __restrict__ in1,                 \
+            const float * __restrict__ in2) {               \
+        size_t i =                                          \
+            vector_add_subtract_simd(size, io, in1, in2);   \
+        for (; i < size; ++i) {                             \
+            io[i] += static_cast<float>(in1[i]) - in2[i];   \
+        }                                                   \
+    }                                                       \
+                                                            \
+    void vector_log(                                        \
+            const size_t size,                              \
+            const float * __restrict__ in,                  \
+            Score * __restrict__ out) {                     \
+        for (size_t i = 0; i < size; ++i) {                 \
+            out[i] = fast_log(in[i]);                       \
+        }                                                   \
+    }
+
+DEFINE_REDUCED_PRECISION_KERNELS(bfloat16_t)
+DEFINE_REDUCED_PRECISION_KERNELS(float16_t)
+
+#undef DEFINE_REDUCED_PRECISION_KERNELS
+
 }   // namespace distributions
 